@@ -0,0 +1,135 @@
+﻿// Copyright Soccertitan 2025
+
+
+#include "Ability/AbilityChargeTypes.h"
+
+#include "CrimAbilitySystemComponent.h"
+
+
+int32 FAbilityChargeItem::GetCharges(double Time, int32 MaxCharges) const
+{
+	if (Charges >= MaxCharges || RechargePeriod <= 0.f)
+	{
+		return FMath::Min(Charges, MaxCharges);
+	}
+
+	const int64 Refilled = FMath::FloorToInt64((Time - LastRefillTime) / RechargePeriod);
+	return static_cast<int32>(FMath::Clamp<int64>(Charges + FMath::Max<int64>(Refilled, 0), 0, MaxCharges));
+}
+
+float FAbilityChargeItem::GetTimeUntilNextCharge(double Time, int32 MaxCharges) const
+{
+	if (RechargePeriod <= 0.f || GetCharges(Time, MaxCharges) >= MaxCharges)
+	{
+		return 0.f;
+	}
+
+	const double Elapsed = FMath::Max(Time - LastRefillTime, 0.0);
+	return static_cast<float>(RechargePeriod - FMath::Fmod(Elapsed, static_cast<double>(RechargePeriod)));
+}
+
+float FAbilityChargeItem::GetTimeUntilCharges(double Time, int32 Count, int32 MaxCharges) const
+{
+	const int32 Missing = FMath::Min(Count, MaxCharges) - GetCharges(Time, MaxCharges);
+	if (Missing <= 0 || RechargePeriod <= 0.f)
+	{
+		return 0.f;
+	}
+
+	return GetTimeUntilNextCharge(Time, MaxCharges) + static_cast<float>(Missing - 1) * RechargePeriod;
+}
+
+void FAbilityChargeItem::Consume(double Time, int32 Count, int32 MaxCharges, float InRechargePeriod)
+{
+	const int32 CurrentCharges = GetCharges(Time, MaxCharges);
+	if (CurrentCharges >= MaxCharges || RechargePeriod <= 0.f)
+	{
+		// The recharge starts with the first charge spent.
+		LastRefillTime = Time;
+	}
+	else
+	{
+		// Move to the last refill, keeping the progress towards the next charge.
+		const int32 Refilled = CurrentCharges - Charges;
+		LastRefillTime += static_cast<double>(Refilled) * RechargePeriod;
+	}
+
+	Charges = FMath::Max(CurrentCharges - Count, 0);
+	RechargePeriod = InRechargePeriod;
+}
+
+void FAbilityChargeItem::PostReplicatedAdd(const FAbilityChargeContainer& InArraySerializer)
+{
+	InArraySerializer.bHandleIndexDirty = true;
+	if (InArraySerializer.Owner)
+	{
+		InArraySerializer.Owner->OnAbilityChargesChanged(*this);
+	}
+}
+
+void FAbilityChargeItem::PostReplicatedChange(const FAbilityChargeContainer& InArraySerializer)
+{
+	if (InArraySerializer.Owner)
+	{
+		InArraySerializer.Owner->OnAbilityChargesChanged(*this);
+	}
+}
+
+void FAbilityChargeItem::PreReplicatedRemove(const FAbilityChargeContainer& InArraySerializer)
+{
+	InArraySerializer.bHandleIndexDirty = true;
+}
+
+void FAbilityChargeContainer::Consume(FGameplayAbilitySpecHandle Handle, double Time, int32 Count, int32 MaxCharges, float RechargePeriod)
+{
+	if (!Owner || !Handle.IsValid())
+	{
+		return;
+	}
+
+	FAbilityChargeItem* Item = const_cast<FAbilityChargeItem*>(Find(Handle));
+	if (!Item)
+	{
+		HandleToIndex.Add(Handle, Items.Num());
+		Item = &Items.AddDefaulted_GetRef();
+		Item->Handle = Handle;
+		Item->Charges = MaxCharges;
+		Item->RechargePeriod = RechargePeriod;
+	}
+
+	Item->Consume(Time, Count, MaxCharges, RechargePeriod);
+	MarkItemDirty(*Item);
+	Owner->OnAbilityChargesChanged(*Item);
+}
+
+void FAbilityChargeContainer::Remove(FGameplayAbilitySpecHandle Handle)
+{
+	const FAbilityChargeItem* Item = Find(Handle);
+	if (Item)
+	{
+		Items.RemoveAtSwap(static_cast<int32>(Item - Items.GetData()));
+		bHandleIndexDirty = true;
+		MarkArrayDirty();
+	}
+}
+
+const FAbilityChargeItem* FAbilityChargeContainer::Find(FGameplayAbilitySpecHandle Handle) const
+{
+	if (bHandleIndexDirty)
+	{
+		HandleToIndex.Reset();
+		for (int32 Index = 0; Index < Items.Num(); ++Index)
+		{
+			HandleToIndex.Add(Items[Index].Handle, Index);
+		}
+		bHandleIndexDirty = false;
+	}
+
+	const int32* Index = HandleToIndex.Find(Handle);
+	return Index && Items.IsValidIndex(*Index) ? &Items[*Index] : nullptr;
+}
+
+void FAbilityChargeContainer::RegisterWithOwner(UCrimAbilitySystemComponent* InOwner)
+{
+	Owner = InOwner;
+}
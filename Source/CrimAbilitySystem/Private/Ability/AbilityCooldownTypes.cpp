@@ -0,0 +1,93 @@
+﻿// Copyright Soccertitan 2025
+
+
+#include "Ability/AbilityCooldownTypes.h"
+
+#include "CrimAbilitySystemComponent.h"
+
+
+void FAbilityCooldownItem::PostReplicatedAdd(const FAbilityCooldownContainer& InArraySerializer)
+{
+	if (InArraySerializer.Owner)
+	{
+		InArraySerializer.Owner->OnNativeCooldownChanged(*this);
+	}
+}
+
+void FAbilityCooldownItem::PostReplicatedChange(const FAbilityCooldownContainer& InArraySerializer)
+{
+	if (InArraySerializer.Owner)
+	{
+		InArraySerializer.Owner->OnNativeCooldownChanged(*this);
+	}
+}
+
+void FAbilityCooldownItem::PreReplicatedRemove(const FAbilityCooldownContainer& InArraySerializer)
+{
+	if (InArraySerializer.Owner)
+	{
+		InArraySerializer.Owner->OnNativeCooldownRemoved(*this);
+	}
+}
+
+void FAbilityCooldownContainer::SetCooldown(const FGameplayTag& CooldownTag, double EndTime, float Duration)
+{
+	if (!Owner || !CooldownTag.IsValid())
+	{
+		return;
+	}
+
+	for (FAbilityCooldownItem& Item : Items)
+	{
+		if (Item.CooldownTag == CooldownTag)
+		{
+			if (Item.EndTime < EndTime)
+			{
+				Item.EndTime = EndTime;
+				Item.Duration = Duration;
+				MarkItemDirty(Item);
+				Owner->OnNativeCooldownChanged(Item);
+			}
+			return;
+		}
+	}
+
+	FAbilityCooldownItem& NewItem = Items.AddDefaulted_GetRef();
+	NewItem.CooldownTag = CooldownTag;
+	NewItem.EndTime = EndTime;
+	NewItem.Duration = Duration;
+	MarkItemDirty(NewItem);
+	Owner->OnNativeCooldownChanged(NewItem);
+}
+
+void FAbilityCooldownContainer::RemoveExpiredCooldowns(double Time)
+{
+	if (!Owner)
+	{
+		return;
+	}
+
+	for (int32 Idx = Items.Num() - 1; Idx >= 0; Idx--)
+	{
+		if (Items[Idx].EndTime <= Time)
+		{
+			const FAbilityCooldownItem OldItem = Items[Idx];
+			Items.RemoveAtSwap(Idx);
+			MarkArrayDirty();
+			Owner->OnNativeCooldownRemoved(OldItem);
+		}
+	}
+}
+
+const FAbilityCooldownItem* FAbilityCooldownContainer::FindCooldown(const FGameplayTag& CooldownTag) const
+{
+	return Items.FindByPredicate([&CooldownTag](const FAbilityCooldownItem& Item)
+	{
+		return Item.CooldownTag == CooldownTag;
+	});
+}
+
+void FAbilityCooldownContainer::RegisterWithOwner(UCrimAbilitySystemComponent* InOwner)
+{
+	Owner = InOwner;
+}
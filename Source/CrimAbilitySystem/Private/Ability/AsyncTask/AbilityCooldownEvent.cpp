@@ -4,6 +4,7 @@
 #include "Ability/AsyncTask/AbilityCooldownEvent.h"
 
 #include "AbilitySystemComponent.h"
+#include "CrimAbilitySystemComponent.h"
 
 UAbilityCooldownEvent* UAbilityCooldownEvent::WaitForCooldownChange(UAbilitySystemComponent* InAbilitySystemComponent, const FGameplayTag& InCooldownTag)
 {
@@ -27,6 +28,12 @@ UAbilityCooldownEvent* UAbilityCooldownEvent::WaitForCooldownChange(UAbilitySyst
 	// To know when a cooldown effect has been applied
 	InAbilitySystemComponent->OnActiveGameplayEffectAddedDelegateToSelf.AddUObject(WaitCooldownChange, &UAbilityCooldownEvent::OnActiveEffectAdded);
 
+	// To know when a native cooldown has been applied
+	if (UCrimAbilitySystemComponent* CrimASC = Cast<UCrimAbilitySystemComponent>(InAbilitySystemComponent))
+	{
+		CrimASC->OnNativeCooldownAppliedDelegate.AddUObject(WaitCooldownChange, &UAbilityCooldownEvent::OnNativeCooldownApplied);
+	}
+
 	return WaitCooldownChange;
 }
 
@@ -34,6 +41,10 @@ void UAbilityCooldownEvent::EndTask()
 {
 	if (!IsValid(AbilitySystemComponent)) return;
 	AbilitySystemComponent->RegisterGameplayTagEvent(CooldownTag, EGameplayTagEventType::NewOrRemoved).RemoveAll(this);
+	if (UCrimAbilitySystemComponent* CrimASC = Cast<UCrimAbilitySystemComponent>(AbilitySystemComponent))
+	{
+		CrimASC->OnNativeCooldownAppliedDelegate.RemoveAll(this);
+	}
 
 	SetReadyToDestroy();
 	MarkAsGarbage();
@@ -74,3 +85,11 @@ void UAbilityCooldownEvent::OnActiveEffectAdded(UAbilitySystemComponent* TargetA
 		}
 	}
 }
+
+void UAbilityCooldownEvent::OnNativeCooldownApplied(UCrimAbilitySystemComponent* CrimAbilitySystemComponent, const FGameplayTag& InCooldownTag, float TimeRemaining, float Duration)
+{
+	if (InCooldownTag == CooldownTag)
+	{
+		CooldownStart.Broadcast(TimeRemaining);
+	}
+}
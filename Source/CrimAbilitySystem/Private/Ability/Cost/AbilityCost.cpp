@@ -2,3 +2,31 @@
 
 
 #include "Ability/Cost/AbilityCost.h"
+
+#include "CrimAbilitySystemComponent.h"
+
+FAbilityCostEvaluation& FAbilityCostEvaluationContext::FindOrAdd(const UAbilityCost* Cost)
+{
+	for (TPair<const UAbilityCost*, FAbilityCostEvaluation>& Pair : Evaluations)
+	{
+		if (Pair.Key == Cost)
+		{
+			return Pair.Value;
+		}
+	}
+	return Evaluations.Emplace_GetRef(Cost, FAbilityCostEvaluation()).Value;
+}
+
+void FAbilityCostEvaluationContext::Reset(uint64 InFrameCounter, uint32 InGeneration)
+{
+	FrameCounter = InFrameCounter;
+	Generation = InGeneration;
+	Evaluations.Reset();
+}
+
+FAbilityCostEvaluation* UAbilityCost::FindCostEvaluation(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo) const
+{
+	const UCrimAbilitySystemComponent* CrimASC = ActorInfo ? Cast<UCrimAbilitySystemComponent>(ActorInfo->AbilitySystemComponent.Get()) : nullptr;
+	FAbilityCostEvaluationContext* Context = CrimASC ? CrimASC->GetCostEvaluationContext(Handle) : nullptr;
+	return Context ? &Context->FindOrAdd(this) : nullptr;
+}
@@ -0,0 +1,96 @@
+﻿// Copyright Soccertitan 2025
+
+
+#include "Ability/Cost/AbilityCost_Attribute.h"
+
+#include "AbilitySystemComponent.h"
+#include "AbilitySystemGlobals.h"
+#include "Abilities/GameplayAbility.h"
+
+bool UAbilityCost_Attribute::CheckCost(const UGameplayAbility* Ability, const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, FGameplayTagContainer* OptionalRelevantTags) const
+{
+	const UAbilitySystemComponent* AbilitySystemComponent = ActorInfo->AbilitySystemComponent.Get();
+	if (!AbilitySystemComponent || !Attribute.IsValid())
+	{
+		return false;
+	}
+
+	bool bFound = false;
+	const float Value = AbilitySystemComponent->GetGameplayAttributeValue(Attribute, bFound);
+	if (bFound && Value >= GetCostAmount(Ability, Handle, ActorInfo))
+	{
+		return true;
+	}
+
+	if (OptionalRelevantTags)
+	{
+		const FGameplayTag& CostFailTag = FailureTag.IsValid() ? FailureTag : UAbilitySystemGlobals::Get().ActivateFailCostTag;
+		if (CostFailTag.IsValid())
+		{
+			OptionalRelevantTags->AddTag(CostFailTag);
+		}
+	}
+	return false;
+}
+
+void UAbilityCost_Attribute::ApplyCost(const UGameplayAbility* Ability, const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilityActivationInfo ActivationInfo)
+{
+	UAbilitySystemComponent* AbilitySystemComponent = ActorInfo->AbilitySystemComponent.Get();
+	if (!AbilitySystemComponent || !Attribute.IsValid() || !AbilitySystemComponent->HasAttributeSetForAttribute(Attribute))
+	{
+		return;
+	}
+
+	const float Amount = GetCostAmount(Ability, Handle, ActorInfo);
+	if (Amount == 0.f)
+	{
+		return;
+	}
+
+	// SetNumericAttributeBase goes through PreAttributeBaseChange, so the attribute set clamps the new value.
+	const float OldBaseValue = AbilitySystemComponent->GetNumericAttributeBase(Attribute);
+	AbilitySystemComponent->SetNumericAttributeBase(Attribute, OldBaseValue - Amount);
+
+	if (!ActorInfo->IsNetAuthority())
+	{
+		// The server's value replicates back if it spent the cost too. If it rejects the activation nothing replicates, so
+		// restore the spend unless the attribute was replicated or changed since.
+		FPredictionKey PredictionKey = ActivationInfo.GetActivationPredictionKey();
+		if (PredictionKey.IsValidKey())
+		{
+			const float PredictedBaseValue = AbilitySystemComponent->GetNumericAttributeBase(Attribute);
+			PredictionKey.NewRejectedDelegate().BindWeakLambda(AbilitySystemComponent, [AbilitySystemComponent, SpentAttribute = Attribute, OldBaseValue, PredictedBaseValue]()
+			{
+				if (AbilitySystemComponent->GetNumericAttributeBase(SpentAttribute) == PredictedBaseValue)
+				{
+					AbilitySystemComponent->SetNumericAttributeBase(SpentAttribute, OldBaseValue);
+				}
+			});
+		}
+	}
+}
+
+void UAbilityCost_Attribute::GetRelevantAttributes(TArray<FGameplayAttribute>& OutAttributes) const
+{
+	if (Attribute.IsValid())
+	{
+		OutAttributes.AddUnique(Attribute);
+	}
+}
+
+float UAbilityCost_Attribute::GetCostAmount(const UGameplayAbility* Ability, const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo) const
+{
+	// CheckCost computes the amount first, ApplyCost reuses it when the activation commits in the same frame.
+	FAbilityCostEvaluation* Evaluation = FindCostEvaluation(Handle, ActorInfo);
+	if (Evaluation && Evaluation->Amount.IsSet())
+	{
+		return Evaluation->Amount.GetValue();
+	}
+
+	const float Amount = Cost.GetValueAtLevel(static_cast<float>(Ability->GetAbilityLevel(Handle, ActorInfo)));
+	if (Evaluation)
+	{
+		Evaluation->Amount = Amount;
+	}
+	return Amount;
+}
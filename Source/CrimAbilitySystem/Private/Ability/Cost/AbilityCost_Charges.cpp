@@ -0,0 +1,35 @@
+﻿// Copyright Soccertitan 2025
+
+
+#include "Ability/Cost/AbilityCost_Charges.h"
+
+#include "AbilityGameplayTags.h"
+#include "CrimAbilitySystemComponent.h"
+
+bool UAbilityCost_Charges::CheckCost(const UGameplayAbility* Ability, const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, FGameplayTagContainer* OptionalRelevantTags) const
+{
+	const UCrimAbilitySystemComponent* CrimASC = Cast<UCrimAbilitySystemComponent>(ActorInfo->AbilitySystemComponent.Get());
+	if (!CrimASC)
+	{
+		return false;
+	}
+
+	if (CrimASC->GetAbilityCharges(Handle, MaxCharges) >= ChargesPerUse)
+	{
+		return true;
+	}
+
+	if (OptionalRelevantTags)
+	{
+		OptionalRelevantTags->AddTag(FailureTag.IsValid() ? FailureTag : FAbilityGameplayTags::Get().Ability_ActivateFail_Charges);
+	}
+	return false;
+}
+
+void UAbilityCost_Charges::ApplyCost(const UGameplayAbility* Ability, const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilityActivationInfo ActivationInfo)
+{
+	if (UCrimAbilitySystemComponent* CrimASC = Cast<UCrimAbilitySystemComponent>(ActorInfo->AbilitySystemComponent.Get()))
+	{
+		CrimASC->ConsumeAbilityCharges(Handle, ChargesPerUse, MaxCharges, RechargePeriod, ActivationInfo);
+	}
+}
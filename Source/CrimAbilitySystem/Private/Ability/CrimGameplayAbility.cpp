@@ -10,9 +10,11 @@
 #include "CrimAbilitySystemComponent.h"
 #include "CrimGameplayEffectContext.h"
 #include "AbilityGameplayTags.h"
+#include "GameplayEffect.h"
 #include "Ability/MessageAbilityActivateFailure.h"
 #include "Ability/Cost/AbilityCost.h"
 #include "GameFramework/GameplayMessageSubsystem.h"
+#include "UObject/UObjectIterator.h"
 
 #define ENSURE_ABILITY_IS_INSTANTIATED_OR_RETURN(FunctionName, ReturnValue)																				\
 {																																						\
@@ -37,6 +39,49 @@ UCrimGameplayAbility::UCrimGameplayAbility(const FObjectInitializer& ObjectIniti
 	bLogCancelation = false;
 }
 
+void UCrimGameplayAbility::PostInitProperties()
+{
+	Super::PostInitProperties();
+
+	if (HasAnyFlags(RF_ClassDefaultObject))
+	{
+		CompileCooldownTags();
+	}
+}
+
+void UCrimGameplayAbility::PostLoad()
+{
+	Super::PostLoad();
+
+	// Blueprint CDOs only have their cooldown properties once they are loaded.
+	if (HasAnyFlags(RF_ClassDefaultObject))
+	{
+		CompileCooldownTags();
+	}
+}
+
+#if WITH_EDITOR
+void UCrimGameplayAbility::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	// The cooldown tags or the cooldown GE may have changed. Child classes inherit both, so their CDOs are rebuilt too.
+	if (HasAnyFlags(RF_ClassDefaultObject))
+	{
+		for (TObjectIterator<UClass> It; It; ++It)
+		{
+			if (It->IsChildOf(GetClass()))
+			{
+				if (UCrimGameplayAbility* AbilityCDO = Cast<UCrimGameplayAbility>(It->GetDefaultObject(false)))
+				{
+					AbilityCDO->CompileCooldownTags();
+				}
+			}
+		}
+	}
+}
+#endif
+
 UCrimAbilitySystemComponent* UCrimGameplayAbility::GetCrimAbilitySystemComponentFromActorInfo() const
 {
 	return (CurrentActorInfo ? Cast<UCrimAbilitySystemComponent>(CurrentActorInfo->AbilitySystemComponent.Get()) : nullptr);
@@ -148,8 +193,8 @@ bool UCrimGameplayAbility::ChangeActivationGroup(EAbilityActivationGroup NewGrou
 		UCrimAbilitySystemComponent* CrimASC = GetCrimAbilitySystemComponentFromActorInfo();
 		check(CrimASC);
 
-		CrimASC->RemoveAbilityFromActivationGroup(ActivationGroup, this);
-		CrimASC->AddAbilityToActivationGroup(NewGroup, this);
+		CrimASC->RemoveAbilityFromActivationGroup(ActivationGroup, this, CurrentSpecHandle);
+		CrimASC->AddAbilityToActivationGroup(NewGroup, this, CurrentSpecHandle);
 
 		ActivationGroup = NewGroup;
 	}
@@ -223,7 +268,18 @@ void UCrimGameplayAbility::OnGiveAbility(const FGameplayAbilityActorInfo* ActorI
 	Super::OnGiveAbility(ActorInfo, Spec);
 
 	K2_OnAbilityAdded();
-	TryActivateAbilityOnSpawn(ActorInfo, Spec);
+
+	if (ActivationPolicy != EAbilityActivationPolicy::OnSpawn)
+	{
+		return;
+	}
+
+	// Batched grants activate their OnSpawn abilities after the whole batch is given.
+	const UCrimAbilitySystemComponent* CrimASC = ActorInfo ? Cast<UCrimAbilitySystemComponent>(ActorInfo->AbilitySystemComponent.Get()) : nullptr;
+	if (!CrimASC || !CrimASC->IsProcessingAbilityBatch())
+	{
+		TryActivateAbilityOnSpawn(ActorInfo, Spec);
+	}
 }
 
 void UCrimGameplayAbility::OnRemoveAbility(const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilitySpec& Spec)
@@ -252,7 +308,42 @@ void UCrimGameplayAbility::EndAbility(const FGameplayAbilitySpecHandle Handle, c
 
 bool UCrimGameplayAbility::CheckCost(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, FGameplayTagContainer* OptionalRelevantTags) const
 {
-	if (!Super::CheckCost(Handle, ActorInfo, OptionalRelevantTags) || !ActorInfo)
+	if (!ActorInfo)
+	{
+		return false;
+	}
+
+	// CanActivateAbility and CommitAbility both check the costs, usually in the same frame. Reuse what the first check
+	// found, including its failure tags, until the ability system invalidates the results.
+	const UCrimAbilitySystemComponent* CrimASC = Cast<UCrimAbilitySystemComponent>(ActorInfo->AbilitySystemComponent.Get());
+	FAbilityCostEvaluationContext* CostContext = CrimASC ? CrimASC->GetCostEvaluationContext(Handle) : nullptr;
+	auto CheckCachedCost = [CostContext, OptionalRelevantTags](const UAbilityCost* Cost, TFunctionRef<bool(FGameplayTagContainer*)> Check)
+	{
+		if (!CostContext)
+		{
+			return Check(OptionalRelevantTags);
+		}
+
+		if (!CostContext->FindOrAdd(Cost).bCanAfford.IsSet())
+		{
+			// The check may add evaluations of its own, look the entry up again afterwards.
+			FGameplayTagContainer FailureTags;
+			const bool bCanAfford = Check(&FailureTags);
+			FAbilityCostEvaluation& Evaluation = CostContext->FindOrAdd(Cost);
+			Evaluation.bCanAfford = bCanAfford;
+			Evaluation.FailureTags = MoveTemp(FailureTags);
+		}
+
+		const FAbilityCostEvaluation& Evaluation = CostContext->FindOrAdd(Cost);
+		if (OptionalRelevantTags)
+		{
+			OptionalRelevantTags->AppendTags(Evaluation.FailureTags);
+		}
+		return Evaluation.bCanAfford.GetValue();
+	};
+
+	// The cost gameplay effect is cached under a null cost.
+	if (!CheckCachedCost(nullptr, [this, Handle, ActorInfo](FGameplayTagContainer* RelevantTags) { return Super::CheckCost(Handle, ActorInfo, RelevantTags); }))
 	{
 		return false;
 	}
@@ -262,7 +353,8 @@ bool UCrimGameplayAbility::CheckCost(const FGameplayAbilitySpecHandle Handle, co
 	{
 		if (AdditionalCost != nullptr)
 		{
-			if (!AdditionalCost->CheckCost(this, Handle, ActorInfo, /*inout*/ OptionalRelevantTags))
+			const UAbilityCost* Cost = AdditionalCost;
+			if (!CheckCachedCost(Cost, [this, Cost, Handle, ActorInfo](FGameplayTagContainer* RelevantTags) { return Cost->CheckCost(this, Handle, ActorInfo, /*inout*/ RelevantTags); }))
 			{
 				return false;
 			}
@@ -324,33 +416,146 @@ void UCrimGameplayAbility::ApplyCost(const FGameplayAbilitySpecHandle Handle, co
 			AdditionalCost->ApplyCost(this, Handle, ActorInfo, ActivationInfo);
 		}
 	}
+
+	// Spending can change what this and the other abilities afford.
+	if (UCrimAbilitySystemComponent* CrimASC = Cast<UCrimAbilitySystemComponent>(ActorInfo->AbilitySystemComponent.Get()))
+	{
+		CrimASC->InvalidateCostEvaluations();
+	}
 }
 
 const FGameplayTagContainer* UCrimGameplayAbility::GetCooldownTags() const
 {
-	FGameplayTagContainer* MutableTags = const_cast<FGameplayTagContainer*>(&TransientCooldownTags);
-	MutableTags->Reset(); // MutableTags writes to the TempCooldownTags on the CDO so clear it in case the ability cooldown tags change (moved to a different slot)
-	const FGameplayTagContainer* ParentTags = Super::GetCooldownTags();
-	if (ParentTags)
+	// Instances share the union built on the CDO.
+	const UCrimGameplayAbility* AbilityCDO = HasAnyFlags(RF_ClassDefaultObject) ? this : GetClass()->GetDefaultObject<UCrimGameplayAbility>();
+	return &AbilityCDO->CompiledCooldownTags;
+}
+
+void UCrimGameplayAbility::CompileCooldownTags()
+{
+	CompiledCooldownTags.Reset();
+	if (UGameplayEffect* CooldownGE = GetCooldownGameplayEffect())
 	{
-		MutableTags->AppendTags(*ParentTags);
+		// The GE's granted tags are cached when it is loaded.
+		CooldownGE->ConditionalPostLoad();
 	}
-	MutableTags->AppendTags(CooldownTags);
-	return MutableTags;
+	if (const FGameplayTagContainer* ParentTags = UGameplayAbility::GetCooldownTags())
+	{
+		CompiledCooldownTags.AppendTags(*ParentTags);
+	}
+	CompiledCooldownTags.AppendTags(CooldownTags);
 }
 
 void UCrimGameplayAbility::ApplyCooldown(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilityActivationInfo ActivationInfo) const
 {
+	if (bUseNativeCooldown)
+	{
+		if (UCrimAbilitySystemComponent* CrimASC = ActorInfo ? Cast<UCrimAbilitySystemComponent>(ActorInfo->AbilitySystemComponent.Get()) : nullptr)
+		{
+			CrimASC->ApplyNativeCooldown(*GetCooldownTags(), GetCooldown(), ActivationInfo);
+			return;
+		}
+	}
+
 	UGameplayEffect* CooldownGE = GetCooldownGameplayEffect();
 	if (CooldownGE)
 	{
-		FGameplayEffectSpecHandle SpecHandle = MakeOutgoingGameplayEffectSpec(CooldownGE->GetClass(), GetAbilityLevel());
-		SpecHandle.Data.Get()->DynamicGrantedTags.AppendTags(*GetCooldownTags());
-		SpecHandle.Data.Get()->SetSetByCallerMagnitude(FAbilityGameplayTags::Get().Ability_Cooldown, GetCooldown());
-		ApplyGameplayEffectSpecToOwner(Handle, ActorInfo, ActivationInfo, SpecHandle);
+		const FGameplayEffectSpecHandle SpecHandle = GetCooldownSpec(Handle, ActorInfo, ActivationInfo, *CooldownGE);
+		if (SpecHandle.IsValid())
+		{
+			SpecHandle.Data->SetSetByCallerMagnitude(FAbilityGameplayTags::Get().Ability_Cooldown, GetCooldown());
+			ApplyGameplayEffectSpecToOwner(Handle, ActorInfo, ActivationInfo, SpecHandle);
+		}
 	}
 }
 
+bool UCrimGameplayAbility::CheckCooldown(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, FGameplayTagContainer* OptionalRelevantTags) const
+{
+	// Without an active native cooldown, fall through to Super so cooldown tags granted by gameplay effects still block.
+	if (bUseNativeCooldown)
+	{
+		const UCrimAbilitySystemComponent* CrimASC = ActorInfo ? Cast<UCrimAbilitySystemComponent>(ActorInfo->AbilitySystemComponent.Get()) : nullptr;
+		if (CrimASC && CrimASC->IsNativeCooldownActive(*GetCooldownTags()))
+		{
+			if (OptionalRelevantTags)
+			{
+				const FGameplayTag& CooldownTag = UAbilitySystemGlobals::Get().ActivateFailCooldownTag;
+				if (CooldownTag.IsValid())
+				{
+					OptionalRelevantTags->AddTag(CooldownTag);
+				}
+
+				// Report the blocking cooldown tags like Super does.
+				OptionalRelevantTags->AppendMatchingTags(CrimASC->GetOwnedGameplayTags(), *GetCooldownTags());
+			}
+			return false;
+		}
+	}
+
+	return Super::CheckCooldown(Handle, ActorInfo, OptionalRelevantTags);
+}
+
+void UCrimGameplayAbility::GetCooldownTimeRemainingAndDuration(FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, float& TimeRemaining, float& CooldownDuration) const
+{
+	if (bUseNativeCooldown)
+	{
+		if (const UCrimAbilitySystemComponent* CrimASC = ActorInfo ? Cast<UCrimAbilitySystemComponent>(ActorInfo->AbilitySystemComponent.Get()) : nullptr)
+		{
+			CrimASC->GetNativeCooldownTimeRemainingAndDuration(*GetCooldownTags(), TimeRemaining, CooldownDuration);
+			return;
+		}
+	}
+
+	Super::GetCooldownTimeRemainingAndDuration(Handle, ActorInfo, TimeRemaining, CooldownDuration);
+}
+
+FGameplayEffectSpecHandle UCrimGameplayAbility::GetCooldownSpec(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilityActivationInfo ActivationInfo, const UGameplayEffect& CooldownGE) const
+{
+	UAbilitySystemComponent* AbilitySystemComponent = ActorInfo ? ActorInfo->AbilitySystemComponent.Get() : nullptr;
+	if (!AbilitySystemComponent)
+	{
+		return FGameplayEffectSpecHandle();
+	}
+
+	UCrimAbilitySystemComponent* CrimASC = Cast<UCrimAbilitySystemComponent>(AbilitySystemComponent);
+	FGameplayAbilitySpec* AbilitySpec = CrimASC ? CrimASC->GetAbilitySpecByHandle(Handle) : AbilitySystemComponent->FindAbilitySpecFromHandle(Handle);
+	const int32 Level = AbilitySpec ? AbilitySpec->Level : 1;
+
+	// Applying copies the spec, so an instance can reuse it and only refresh the context. The CDO is shared between ASCs and
+	// a spec with modifiers, executions or a calculated duration captures attributes, those are built every time. So is a
+	// spec carrying SetByCaller magnitudes from the ability spec, which can change without the level or tags changing.
+	const bool bCanCacheSpec = IsInstantiated() && CooldownGE.Modifiers.IsEmpty() && CooldownGE.Executions.IsEmpty()
+		&& (!AbilitySpec || AbilitySpec->SetByCallerTagMagnitudes.IsEmpty())
+		&& CooldownGE.DurationMagnitude.GetMagnitudeCalculationType() != EGameplayEffectMagnitudeCalculation::AttributeBased
+		&& CooldownGE.DurationMagnitude.GetMagnitudeCalculationType() != EGameplayEffectMagnitudeCalculation::CustomCalculationClass;
+
+	if (bCanCacheSpec && CachedCooldownSpec.IsValid() && CachedCooldownSpec.Data->Def == &CooldownGE && CachedCooldownLevel == Level
+		&& CachedCooldownAbilitySystem.Get() == AbilitySystemComponent
+		&& (!AbilitySpec || CachedCooldownDynamicTags == AbilitySpec->GetDynamicSpecSourceTags()))
+	{
+		CachedCooldownSpec.Data->SetContext(MakeEffectContext(Handle, ActorInfo));
+		return CachedCooldownSpec;
+	}
+
+	// Built through MakeOutgoingGameplayEffectSpec so the ability tags, the spec's SetByCaller magnitudes and any override apply.
+	FGameplayEffectSpecHandle SpecHandle = MakeOutgoingGameplayEffectSpec(Handle, ActorInfo, ActivationInfo, CooldownGE.GetClass(), Level);
+	if (!SpecHandle.IsValid())
+	{
+		return SpecHandle;
+	}
+
+	SpecHandle.Data->DynamicGrantedTags.AppendTags(*GetCooldownTags());
+
+	if (bCanCacheSpec)
+	{
+		CachedCooldownSpec = SpecHandle;
+		CachedCooldownLevel = Level;
+		CachedCooldownAbilitySystem = AbilitySystemComponent;
+		CachedCooldownDynamicTags = AbilitySpec ? AbilitySpec->GetDynamicSpecSourceTags() : FGameplayTagContainer();
+	}
+	return SpecHandle;
+}
+
 FGameplayEffectContextHandle UCrimGameplayAbility::MakeEffectContext(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo) const
 {
 	FGameplayEffectContextHandle ContextHandle = Super::MakeEffectContext(Handle, ActorInfo);
@@ -406,28 +611,33 @@ bool UCrimGameplayAbility::DoesAbilitySatisfyTagRequirements(const UAbilitySyste
 		bBlocked = true;
 	}
 
+	// Expand our ability tags to add additional required/blocked tags. The expansion is cached per ability class on the ASC.
 	const UCrimAbilitySystemComponent* CrimASC = Cast<UCrimAbilitySystemComponent>(&AbilitySystemComponent);
-	static FGameplayTagContainer AllRequiredTags;
-	static FGameplayTagContainer AllBlockedTags;
-
-	AllRequiredTags = ActivationRequiredTags;
-	AllBlockedTags = ActivationBlockedTags;
-
-	// Expand our ability tags to add additional required/blocked tags
-	if (CrimASC)
-	{
-		CrimASC->GetAdditionalActivationTagRequirements(GetAssetTags(), AllRequiredTags, AllBlockedTags);
-	}
+	const FCrimAbilityActivationTagRequirements* ActivationTagRequirements = CrimASC ? &CrimASC->GetActivationTagRequirements(*this) : nullptr;
+	const FGameplayTagContainer& AllRequiredTags = ActivationTagRequirements ? ActivationTagRequirements->RequiredTags : ActivationRequiredTags;
+	const FGameplayTagContainer& AllBlockedTags = ActivationTagRequirements ? ActivationTagRequirements->BlockedTags : ActivationBlockedTags;
 
 	// Check to see the required/blocked tags for this ability
 	if (AllBlockedTags.Num() || AllRequiredTags.Num())
 	{
-		static FGameplayTagContainer AbilitySystemComponentTags;
-		
-		AbilitySystemComponentTags.Reset();
-		AbilitySystemComponent.GetOwnedGameplayTags(AbilitySystemComponentTags);
+		const FGameplayTagContainer& AbilitySystemComponentTags = AbilitySystemComponent.GetOwnedGameplayTags();
+
+		// Compare the compiled bit sets when every tag fits in the bit set universe.
+		bool bHasBlockedTags;
+		bool bHasRequiredTags;
+		if (ActivationTagRequirements && ActivationTagRequirements->bHasBits)
+		{
+			const FCrimGameplayTagBitSet& OwnedTagBits = CrimASC->GetOwnedGameplayTagBits();
+			bHasBlockedTags = OwnedTagBits.HasAny(ActivationTagRequirements->BlockedBits);
+			bHasRequiredTags = OwnedTagBits.HasAll(ActivationTagRequirements->RequiredBits);
+		}
+		else
+		{
+			bHasBlockedTags = AbilitySystemComponentTags.HasAny(AllBlockedTags);
+			bHasRequiredTags = AbilitySystemComponentTags.HasAll(AllRequiredTags);
+		}
 
-		if (AbilitySystemComponentTags.HasAny(AllBlockedTags))
+		if (bHasBlockedTags)
 		{
 			if (OptionalRelevantTags && AbilitySystemComponentTags.HasTag(FAbilityGameplayTags::Get().Gameplay_State_Death))
 			{
@@ -437,7 +647,7 @@ bool UCrimGameplayAbility::DoesAbilitySatisfyTagRequirements(const UAbilitySyste
 			bBlocked = true;
 		}
 
-		if (!AbilitySystemComponentTags.HasAll(AllRequiredTags))
+		if (!bHasRequiredTags)
 		{
 			bMissing = true;
 		}
@@ -15,6 +15,7 @@ void FAbilityGameplayTags::InitializeNativeGameplayTags()
 	GameplayTags.Message = UGameplayTagsManager::Get().AddNativeGameplayTag(FName("Message"), FString("Root Gameplay Tag to send messages via Gameplay Message Subsystem."));
 
 	GameplayTags.Ability_ActivateFail_ActivationGroup = UGameplayTagsManager::Get().AddNativeGameplayTag(FName("Ability.ActivateFail.ActivationGroup"), FString("Ability Failed due to activation group requirements."));
+	GameplayTags.Ability_ActivateFail_Charges = UGameplayTagsManager::Get().AddNativeGameplayTag(FName("Ability.ActivateFail.Charges"), FString("Ability failed to activate because it has no charges left."));
 	GameplayTags.Ability_ActivateFail_IsDead = UGameplayTagsManager::Get().AddNativeGameplayTag(FName("Ability.ActivateFail.IsDead"), FString("Ability failed to activate due to death."));
 	GameplayTags.Ability_Cooldown = UGameplayTagsManager::Get().AddNativeGameplayTag(FName("Ability.Cooldown"), FString("Root gameplay tag for all cooldown ability tags."));
 	GameplayTags.Ability_GameplayEvent_Death = UGameplayTagsManager::Get().AddNativeGameplayTag(FName("Ability.GameplayEvent.Death"), FString("Triggers death gameplay abilities."));
@@ -0,0 +1,260 @@
+﻿// Copyright Soccertitan 2025
+
+
+#include "AbilityInteractionMatrix.h"
+
+#include "AbilitySet.h"
+#include "AbilityTagRelationshipMapping.h"
+#include "Ability/CrimGameplayAbility.h"
+#include "CrimAbilityLogChannels.h"
+#include "Misc/Crc.h"
+#include "UObject/ObjectSaveContext.h"
+
+namespace CrimAbilityInteractionMatrix
+{
+	// Hashed from the tag names so the hash is stable between sessions. Containers compare equal regardless of the
+	// order their tags were added in, so the tag hashes are summed.
+	static uint32 HashTags(const FGameplayTagContainer& Tags)
+	{
+		uint32 Hash = Tags.Num();
+		for (const FGameplayTag& Tag : Tags)
+		{
+			Hash += FCrc::StrCrc32(*Tag.ToString());
+		}
+		return Hash;
+	}
+}
+
+void UAbilityInteractionMatrix::PostLoad()
+{
+	Super::PostLoad();
+
+	RebuildInteractionIndex();
+
+#if WITH_EDITOR
+	if (TagRelationshipMapping)
+	{
+		TagRelationshipMapping->ConditionalPostLoad();
+	}
+	if (!IsUpToDate())
+	{
+		UE_LOG(LogCrimAbilitySystem, Warning, TEXT("%s is out of date with its mapping or abilities and won't be used until it is rebuilt. Run the AbilityInteractionMatrix commandlet."), *GetPathName());
+	}
+#endif
+}
+
+#if WITH_EDITOR
+void UAbilityInteractionMatrix::PreSave(FObjectPreSaveContext ObjectSaveContext)
+{
+	Super::PreSave(ObjectSaveContext);
+
+	// Cooked data must match the abilities and mapping it ships with.
+	if (ObjectSaveContext.IsCooking())
+	{
+		Build();
+	}
+}
+#endif
+
+void UAbilityInteractionMatrix::Build(TArray<FString>* OutIssues)
+{
+	// The abilities and their tags expanded through the mapping.
+	struct FResolvedAbility
+	{
+		const UCrimGameplayAbility* AbilityCDO = nullptr;
+		FGameplayTagContainer BlockTags;
+		FGameplayTagContainer CancelTags;
+	};
+
+	TArray<TSubclassOf<UGameplayAbility>> AbilityClasses;
+	for (const UAbilitySet* AbilitySet : AbilitySets)
+	{
+		if (AbilitySet)
+		{
+			for (const FAbilitySet_GameplayAbility& AbilityToGrant : AbilitySet->GetGrantedGameplayAbilities())
+			{
+				AbilityClasses.AddUnique(AbilityToGrant.Ability);
+			}
+		}
+	}
+	for (const TSubclassOf<UGameplayAbility>& AbilityClass : AdditionalAbilities)
+	{
+		AbilityClasses.AddUnique(AbilityClass);
+	}
+
+	const FAbilityTagRelationshipTable* Table = TagRelationshipMapping ? &TagRelationshipMapping->GetCompiledTable() : nullptr;
+
+	TArray<FResolvedAbility> ResolvedAbilities;
+	for (const TSubclassOf<UGameplayAbility>& AbilityClass : AbilityClasses)
+	{
+		const UCrimGameplayAbility* AbilityCDO = Cast<UCrimGameplayAbility>(AbilityClass ? AbilityClass->GetDefaultObject() : nullptr);
+		if (!AbilityCDO)
+		{
+			// Only the CrimGameplayAbility tags can be read, the ASC falls back to the tags when such an ability is granted.
+			if (AbilityClass && OutIssues)
+			{
+				OutIssues->Add(FString::Printf(TEXT("%s is not a CrimGameplayAbility and can't be resolved."), *AbilityClass->GetName()));
+			}
+			continue;
+		}
+
+		FResolvedAbility& Resolved = ResolvedAbilities.AddDefaulted_GetRef();
+		Resolved.AbilityCDO = AbilityCDO;
+		Resolved.BlockTags = AbilityCDO->BlockAbilitiesWithTag;
+		Resolved.CancelTags = AbilityCDO->CancelAbilitiesWithTag;
+
+		FGameplayTagContainer RequiredTags = AbilityCDO->ActivationRequiredTags;
+		FGameplayTagContainer BlockedTags = AbilityCDO->ActivationBlockedTags;
+		if (Table)
+		{
+			Table->GetAbilityTagsToBlockAndCancel(AbilityCDO->GetAssetTags(), &Resolved.BlockTags, &Resolved.CancelTags);
+			Table->GetRequiredAndBlockedActivationTags(AbilityCDO->GetAssetTags(), &RequiredTags, &BlockedTags);
+		}
+
+		if (OutIssues)
+		{
+			const FGameplayTagContainer Contradicting = RequiredTags.FilterExact(BlockedTags);
+			if (!Contradicting.IsEmpty())
+			{
+				OutIssues->Add(FString::Printf(TEXT("%s can never activate, it requires and is blocked by %s."), *AbilityClass->GetName(), *Contradicting.ToStringSimple()));
+			}
+		}
+	}
+
+	Interactions.Reset(ResolvedAbilities.Num());
+	for (const FResolvedAbility& Resolved : ResolvedAbilities)
+	{
+		FAbilityInteraction& Interaction = Interactions.AddDefaulted_GetRef();
+		Interaction.Ability = Resolved.AbilityCDO->GetClass();
+		Interaction.AssetTags = Resolved.AbilityCDO->GetAssetTags();
+		Interaction.CancelTags = Resolved.AbilityCDO->CancelAbilitiesWithTag;
+
+		for (const FResolvedAbility& Other : ResolvedAbilities)
+		{
+			// Same test as ApplyAbilityBlockAndCancelTags, the other ability's tags against the expanded block and cancel tags.
+			const FGameplayTagContainer& OtherAbilityTags = Other.AbilityCDO->GetAssetTags();
+			if (OtherAbilityTags.HasAny(Resolved.BlockTags))
+			{
+				Interaction.BlockedAbilities.Add(Other.AbilityCDO->GetClass());
+			}
+			if (OtherAbilityTags.HasAny(Resolved.CancelTags))
+			{
+				Interaction.CanceledAbilities.Add(Other.AbilityCDO->GetClass());
+			}
+		}
+	}
+
+	// Rules that never apply to any of the abilities.
+	if (OutIssues && Table)
+	{
+		for (const TPair<FGameplayTag, FAbilityTagRelationshipEntry>& Pair : Table->Entries)
+		{
+			const FResolvedAbility* Source = ResolvedAbilities.FindByPredicate([&Pair](const FResolvedAbility& Resolved)
+			{
+				return Resolved.AbilityCDO->GetAssetTags().HasTag(Pair.Key);
+			});
+			if (!Source)
+			{
+				OutIssues->Add(FString::Printf(TEXT("%s: no ability has the tag, the relationship is unreachable."), *Pair.Key.ToString()));
+				continue;
+			}
+
+			const FGameplayTagContainer& Targets = Pair.Value.AbilityTagsToBlock;
+			const FGameplayTagContainer& CancelTargets = Pair.Value.AbilityTagsToCancel;
+			const bool bHasTarget = ResolvedAbilities.ContainsByPredicate([&Targets, &CancelTargets](const FResolvedAbility& Resolved)
+			{
+				return Resolved.AbilityCDO->GetAssetTags().HasAny(Targets) || Resolved.AbilityCDO->GetAssetTags().HasAny(CancelTargets);
+			});
+			if (!bHasTarget && (!Targets.IsEmpty() || !CancelTargets.IsEmpty()))
+			{
+				OutIssues->Add(FString::Printf(TEXT("%s: the tags to block and cancel match no ability."), *Pair.Key.ToString()));
+			}
+		}
+	}
+
+	RebuildInteractionIndex();
+	InputHash = ComputeInputHash();
+
+#if WITH_EDITORONLY_DATA
+	bUpToDate = true;
+	UpToDateCheckFrame = GFrameCounter;
+#endif
+}
+
+const FAbilityInteraction* UAbilityInteractionMatrix::FindInteraction(const UClass* AbilityClass) const
+{
+	const int32* Index = InteractionIndex.Find(AbilityClass);
+	return Index ? &Interactions[*Index] : nullptr;
+}
+
+const FAbilityInteraction* UAbilityInteractionMatrix::FindInteraction(const UGameplayAbility& Ability) const
+{
+	const UCrimGameplayAbility* CrimAbility = Cast<UCrimGameplayAbility>(&Ability);
+	const FAbilityInteraction* Interaction = CrimAbility ? FindInteraction(CrimAbility->GetClass()) : nullptr;
+	if (Interaction && Interaction->AssetTags == CrimAbility->GetAssetTags() && Interaction->CancelTags == CrimAbility->CancelAbilitiesWithTag)
+	{
+		return Interaction;
+	}
+	return nullptr;
+}
+
+bool UAbilityInteractionMatrix::IsUpToDate() const
+{
+#if WITH_EDITOR
+	if (UpToDateCheckFrame != GFrameCounter)
+	{
+		bUpToDate = ComputeInputHash() == InputHash;
+		UpToDateCheckFrame = GFrameCounter;
+	}
+	return bUpToDate;
+#else
+	return true;
+#endif
+}
+
+uint32 UAbilityInteractionMatrix::ComputeInputHash() const
+{
+	using namespace CrimAbilityInteractionMatrix;
+
+	uint32 Hash = 0;
+	if (TagRelationshipMapping)
+	{
+		for (const TPair<FGameplayTag, FAbilityTagRelationshipEntry>& Pair : TagRelationshipMapping->GetCompiledTable().Entries)
+		{
+			uint32 EntryHash = FCrc::StrCrc32(*Pair.Key.ToString());
+			EntryHash = HashCombine(EntryHash, HashTags(Pair.Value.AbilityTagsToBlock));
+			EntryHash = HashCombine(EntryHash, HashTags(Pair.Value.AbilityTagsToCancel));
+			EntryHash = HashCombine(EntryHash, HashTags(Pair.Value.ActivationRequiredTags));
+			EntryHash = HashCombine(EntryHash, HashTags(Pair.Value.ActivationBlockedTags));
+			Hash += EntryHash;
+		}
+	}
+
+	for (const FAbilityInteraction& Interaction : Interactions)
+	{
+		const UCrimGameplayAbility* AbilityCDO = Cast<UCrimGameplayAbility>(Interaction.Ability ? Interaction.Ability->GetDefaultObject() : nullptr);
+		if (!AbilityCDO)
+		{
+			continue;
+		}
+
+		uint32 AbilityHash = FCrc::StrCrc32(*AbilityCDO->GetClass()->GetPathName());
+		AbilityHash = HashCombine(AbilityHash, HashTags(AbilityCDO->GetAssetTags()));
+		AbilityHash = HashCombine(AbilityHash, HashTags(AbilityCDO->BlockAbilitiesWithTag));
+		AbilityHash = HashCombine(AbilityHash, HashTags(AbilityCDO->CancelAbilitiesWithTag));
+		Hash += AbilityHash;
+	}
+	return Hash;
+}
+
+void UAbilityInteractionMatrix::RebuildInteractionIndex()
+{
+	InteractionIndex.Reset();
+	for (int32 Index = 0; Index < Interactions.Num(); ++Index)
+	{
+		if (Interactions[Index].Ability)
+		{
+			InteractionIndex.Add(Interactions[Index].Ability.Get(), Index);
+		}
+	}
+}
@@ -0,0 +1,67 @@
+﻿// Copyright Soccertitan 2025
+
+
+#include "AbilityInteractionMatrixCommandlet.h"
+
+#include "AbilityInteractionMatrix.h"
+#include "CrimAbilityLogChannels.h"
+#include "AssetRegistry/IAssetRegistry.h"
+#include "Misc/PackageName.h"
+#include "UObject/SavePackage.h"
+
+UAbilityInteractionMatrixCommandlet::UAbilityInteractionMatrixCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UAbilityInteractionMatrixCommandlet::Main(const FString& Params)
+{
+	const bool bSave = FParse::Param(*Params, TEXT("save"));
+
+	IAssetRegistry& AssetRegistry = IAssetRegistry::GetChecked();
+	AssetRegistry.SearchAllAssets(true);
+
+	TArray<FAssetData> Assets;
+	AssetRegistry.GetAssetsByClass(UAbilityInteractionMatrix::StaticClass()->GetClassPathName(), Assets, true);
+
+	int32 NumIssues = 0;
+	for (const FAssetData& Asset : Assets)
+	{
+		UAbilityInteractionMatrix* Matrix = Cast<UAbilityInteractionMatrix>(Asset.GetAsset());
+		if (!Matrix)
+		{
+			continue;
+		}
+
+		TArray<FString> Issues;
+		Matrix->Build(&Issues);
+		NumIssues += Issues.Num();
+
+		UE_LOG(LogCrimAbilitySystem, Display, TEXT("%s: %d issues."), *Matrix->GetPathName(), Issues.Num());
+		for (const FString& Issue : Issues)
+		{
+			UE_LOG(LogCrimAbilitySystem, Warning, TEXT("%s: %s"), *Matrix->GetName(), *Issue);
+		}
+
+#if WITH_EDITOR
+		if (bSave)
+		{
+			UPackage* Package = Matrix->GetPackage();
+			Package->MarkPackageDirty();
+
+			FSavePackageArgs SaveArgs;
+			SaveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+			const FString Filename = FPackageName::LongPackageNameToFilename(Package->GetName(), FPackageName::GetAssetPackageExtension());
+			if (!UPackage::SavePackage(Package, Matrix, *Filename, SaveArgs))
+			{
+				UE_LOG(LogCrimAbilitySystem, Error, TEXT("Failed to save %s."), *Filename);
+			}
+		}
+#endif
+	}
+
+	UE_LOG(LogCrimAbilitySystem, Display, TEXT("Built %d ability interaction matrices, %d issues."), Assets.Num(), NumIssues);
+	return 0;
+}
@@ -51,13 +51,7 @@ void FAbilitySet_GrantedHandles::TakeFromAbilitySystem(UCrimAbilitySystemCompone
 		return;
 	}
 
-	for (const FGameplayAbilitySpecHandle& Handle : AbilitySpecHandles)
-	{
-		if (Handle.IsValid())
-		{
-			AbilitySystemComponent->ClearAbility(Handle);
-		}
-	}
+	AbilitySystemComponent->ClearAbilities(AbilitySpecHandles);
 
 	for (const FActiveGameplayEffectHandle& Handle : GameplayEffectHandles)
 	{
@@ -120,6 +114,8 @@ void UAbilitySet::GiveToAbilitySystem(UAbilitySystemComponent* AbilitySystemComp
 	}
 
 	// Grant the gameplay abilities.
+	TArray<FGameplayAbilitySpec> AbilitySpecs;
+	AbilitySpecs.Reserve(GrantedGameplayAbilities.Num());
 	for (int32 AbilityIndex = 0; AbilityIndex < GrantedGameplayAbilities.Num(); ++AbilityIndex)
 	{
 		const FAbilitySet_GameplayAbility& AbilityToGrant = GrantedGameplayAbilities[AbilityIndex];
@@ -132,13 +128,27 @@ void UAbilitySet::GiveToAbilitySystem(UAbilitySystemComponent* AbilitySystemComp
 
 		UGameplayAbility* AbilityCDO = AbilityToGrant.Ability->GetDefaultObject<UGameplayAbility>();
 
-		FGameplayAbilitySpec AbilitySpec(AbilityCDO, AbilityToGrant.AbilityLevel);
+		FGameplayAbilitySpec& AbilitySpec = AbilitySpecs.Emplace_GetRef(AbilityCDO, AbilityToGrant.AbilityLevel);
 		AbilitySpec.SourceObject = SourceObject;
 		AbilitySpec.GetDynamicSpecSourceTags().AppendTags(AbilityToGrant.DynamicTags);
+	}
 
-		const FGameplayAbilitySpecHandle AbilitySpecHandle = AbilitySystemComponent->GiveAbility(AbilitySpec);
+	TArray<FGameplayAbilitySpecHandle> AbilitySpecHandles;
+	if (UCrimAbilitySystemComponent* CrimASC = Cast<UCrimAbilitySystemComponent>(AbilitySystemComponent))
+	{
+		CrimASC->GiveAbilities(AbilitySpecs, &AbilitySpecHandles);
+	}
+	else
+	{
+		for (const FGameplayAbilitySpec& AbilitySpec : AbilitySpecs)
+		{
+			AbilitySpecHandles.Add(AbilitySystemComponent->GiveAbility(AbilitySpec));
+		}
+	}
 
-		if (OutGrantedHandles)
+	if (OutGrantedHandles)
+	{
+		for (const FGameplayAbilitySpecHandle& AbilitySpecHandle : AbilitySpecHandles)
 		{
 			OutGrantedHandles->AddAbilitySpecHandle(AbilitySpecHandle);
 		}
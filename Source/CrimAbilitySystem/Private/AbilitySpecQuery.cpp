@@ -0,0 +1,63 @@
+﻿// Copyright Soccertitan 2025
+
+
+#include "AbilitySpecQuery.h"
+
+#include "CrimAbilitySystemComponent.h"
+#include "GameplayAbilitySpec.h"
+
+
+bool FCrimAbilitySpecQuery::Matches(const UCrimAbilitySystemComponent& AbilitySystemComponent, const FGameplayAbilitySpec& AbilitySpec) const
+{
+	const UGameplayAbility* AbilityCDO = AbilitySpec.Ability;
+	if (!AbilityCDO)
+	{
+		return false;
+	}
+
+	if (AbilityClass && AbilityCDO->GetClass() != AbilityClass)
+	{
+		return false;
+	}
+
+	if (ActiveState.IsSet() && AbilitySpec.IsActive() != ActiveState.GetValue())
+	{
+		return false;
+	}
+
+	for (const FGameplayTag& Tag : AssetTags)
+	{
+		if (!AbilityCDO->GetAssetTags().HasTag(Tag))
+		{
+			return false;
+		}
+	}
+
+	for (const FGameplayTag& Tag : DynamicTags)
+	{
+		if (!AbilitySpec.GetDynamicSpecSourceTags().HasTag(Tag))
+		{
+			return false;
+		}
+	}
+
+	if (ActivationGroup.IsSet() && AbilitySpec.IsActive())
+	{
+		// The same per instance groups the ASC's running ability registry tracks, ChangeActivationGroup moves them.
+		if (!AbilitySystemComponent.IsAbilitySpecRunningInActivationGroup(AbilitySpec.Handle, ActivationGroup.GetValue()))
+		{
+			return false;
+		}
+	}
+	else if (ActivationGroup.IsSet())
+	{
+		const UGameplayAbility* PrimaryInstance = AbilitySpec.GetPrimaryInstance();
+		const UCrimGameplayAbility* CrimAbility = Cast<UCrimGameplayAbility>(PrimaryInstance ? PrimaryInstance : AbilityCDO);
+		if (!CrimAbility || CrimAbility->GetActivationGroup() != ActivationGroup.GetValue())
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
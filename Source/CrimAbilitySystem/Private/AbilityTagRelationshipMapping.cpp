@@ -3,55 +3,198 @@
 
 #include "AbilityTagRelationshipMapping.h"
 
-void UAbilityTagRelationshipMapping::GetAbilityTagsToBlockAndCancel(const FGameplayTagContainer& AbilityTags, FGameplayTagContainer* OutTagsToBlock, FGameplayTagContainer* OutTagsToCancel) const
+namespace CrimTagRelationshipLayers
 {
-	for (int32 i = 0; i < AbilityTagRelationships.Num(); i++)
+	// An ordered stack of mappings.
+	struct FLayerKey
 	{
-		const FAbilityTagRelationship& Tags = AbilityTagRelationships[i];
-		if (AbilityTags.HasTag(Tags.AbilityTag))
+		TArray<TObjectKey<UAbilityTagRelationshipMapping>, TInlineAllocator<4>> Layers;
+
+		bool operator==(const FLayerKey& Other) const { return Layers == Other.Layers; }
+
+		friend uint32 GetTypeHash(const FLayerKey& Key)
 		{
-			if (OutTagsToBlock)
+			uint32 Hash = 0;
+			for (const TObjectKey<UAbilityTagRelationshipMapping>& Layer : Key.Layers)
 			{
-				OutTagsToBlock->AppendTags(Tags.AbilityTagsToBlock);
-			}
-			if (OutTagsToCancel)
-			{
-				OutTagsToCancel->AppendTags(Tags.AbilityTagsToCancel);
+				Hash = HashCombineFast(Hash, GetTypeHash(Layer));
 			}
+			return Hash;
 		}
+	};
+
+	// The merged tables of the layer stacks in use.
+	static TMap<FLayerKey, TWeakPtr<const FAbilityTagRelationshipTable>> MergedTables;
+
+	// Bumped whenever a mapping is edited.
+	static uint32 MappingGeneration = 0;
+}
+
+void FAbilityTagRelationshipTable::Compile(TConstArrayView<FAbilityTagRelationship> Relationships)
+{
+	Entries.Reset();
+	for (const FAbilityTagRelationship& Relationship : Relationships)
+	{
+		if (!Relationship.AbilityTag.IsValid())
+		{
+			continue;
+		}
+
+		FAbilityTagRelationshipEntry& Entry = Entries.FindOrAdd(Relationship.AbilityTag);
+		Entry.AbilityTagsToBlock.AppendTags(Relationship.AbilityTagsToBlock);
+		Entry.AbilityTagsToCancel.AppendTags(Relationship.AbilityTagsToCancel);
+		Entry.ActivationRequiredTags.AppendTags(Relationship.ActivationRequiredTags);
+		Entry.ActivationBlockedTags.AppendTags(Relationship.ActivationBlockedTags);
 	}
+	Entries.Compact();
 }
 
-void UAbilityTagRelationshipMapping::GetRequiredAndBlockedActivationTags(const FGameplayTagContainer& AbilityTags, FGameplayTagContainer* OutActivationRequired, FGameplayTagContainer* OutActivationBlocked) const
+void FAbilityTagRelationshipTable::Merge(const FAbilityTagRelationshipTable& Other)
+{
+	for (const TPair<FGameplayTag, FAbilityTagRelationshipEntry>& Pair : Other.Entries)
+	{
+		FAbilityTagRelationshipEntry& Entry = Entries.FindOrAdd(Pair.Key);
+		Entry.AbilityTagsToBlock.AppendTags(Pair.Value.AbilityTagsToBlock);
+		Entry.AbilityTagsToCancel.AppendTags(Pair.Value.AbilityTagsToCancel);
+		Entry.ActivationRequiredTags.AppendTags(Pair.Value.ActivationRequiredTags);
+		Entry.ActivationBlockedTags.AppendTags(Pair.Value.ActivationBlockedTags);
+	}
+}
+
+void FAbilityTagRelationshipTable::GetAbilityTagsToBlockAndCancel(const FGameplayTagContainer& AbilityTags, FGameplayTagContainer* OutTagsToBlock, FGameplayTagContainer* OutTagsToCancel) const
 {
-	for (int32 i = 0; i < AbilityTagRelationships.Num(); i++)
+	ForEachMatchingEntry(AbilityTags, [OutTagsToBlock, OutTagsToCancel](const FAbilityTagRelationshipEntry& Entry)
 	{
-		const FAbilityTagRelationship& Tags = AbilityTagRelationships[i];
-		if (AbilityTags.HasTag(Tags.AbilityTag))
+		if (OutTagsToBlock)
 		{
-			if (OutActivationRequired)
-			{
-				OutActivationRequired->AppendTags(Tags.ActivationRequiredTags);
-			}
-			if (OutActivationBlocked)
-			{
-				OutActivationBlocked->AppendTags(Tags.ActivationBlockedTags);
-			}
+			OutTagsToBlock->AppendTags(Entry.AbilityTagsToBlock);
+		}
+		if (OutTagsToCancel)
+		{
+			OutTagsToCancel->AppendTags(Entry.AbilityTagsToCancel);
+		}
+	});
+}
+
+void FAbilityTagRelationshipTable::GetRequiredAndBlockedActivationTags(const FGameplayTagContainer& AbilityTags, FGameplayTagContainer* OutActivationRequired, FGameplayTagContainer* OutActivationBlocked) const
+{
+	ForEachMatchingEntry(AbilityTags, [OutActivationRequired, OutActivationBlocked](const FAbilityTagRelationshipEntry& Entry)
+	{
+		if (OutActivationRequired)
+		{
+			OutActivationRequired->AppendTags(Entry.ActivationRequiredTags);
+		}
+		if (OutActivationBlocked)
+		{
+			OutActivationBlocked->AppendTags(Entry.ActivationBlockedTags);
 		}
+	});
+}
+
+bool FAbilityTagRelationshipTable::IsAbilityCancelledByTag(const FGameplayTagContainer& AbilityTags, const FGameplayTag& ActionTag) const
+{
+	const FAbilityTagRelationshipEntry* Entry = Entries.Find(ActionTag);
+	return Entry && Entry->AbilityTagsToCancel.HasAny(AbilityTags);
+}
+
+void UAbilityTagRelationshipMapping::PostLoad()
+{
+	Super::PostLoad();
+
+	CompiledTable.Compile(AbilityTagRelationships);
+	bCompiled = true;
+}
+
+#if WITH_EDITOR
+void UAbilityTagRelationshipMapping::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	CompiledTable.Compile(AbilityTagRelationships);
+	bCompiled = true;
+
+	// Stacks merged before the edit are stale, merge them again on next use.
+	CrimTagRelationshipLayers::MergedTables.Reset();
+	++CrimTagRelationshipLayers::MappingGeneration;
+}
+#endif
+
+const FAbilityTagRelationshipTable& UAbilityTagRelationshipMapping::GetCompiledTable() const
+{
+	// Mappings created at runtime are never loaded, compile them on first use.
+	if (!bCompiled)
+	{
+		check(IsInGameThread());
+		CompiledTable.Compile(AbilityTagRelationships);
+		bCompiled = true;
 	}
+	return CompiledTable;
+}
+
+void UAbilityTagRelationshipMapping::GetAbilityTagsToBlockAndCancel(const FGameplayTagContainer& AbilityTags, FGameplayTagContainer* OutTagsToBlock, FGameplayTagContainer* OutTagsToCancel) const
+{
+	GetCompiledTable().GetAbilityTagsToBlockAndCancel(AbilityTags, OutTagsToBlock, OutTagsToCancel);
+}
+
+void UAbilityTagRelationshipMapping::GetRequiredAndBlockedActivationTags(const FGameplayTagContainer& AbilityTags, FGameplayTagContainer* OutActivationRequired, FGameplayTagContainer* OutActivationBlocked) const
+{
+	GetCompiledTable().GetRequiredAndBlockedActivationTags(AbilityTags, OutActivationRequired, OutActivationBlocked);
 }
 
 bool UAbilityTagRelationshipMapping::IsAbilityCancelledByTag(const FGameplayTagContainer& AbilityTags, const FGameplayTag& ActionTag) const
 {
-	for (int32 i = 0; i < AbilityTagRelationships.Num(); i++)
+	return GetCompiledTable().IsAbilityCancelledByTag(AbilityTags, ActionTag);
+}
+
+TSharedPtr<const FAbilityTagRelationshipTable> UAbilityTagRelationshipMapping::FindOrCompileLayers(TConstArrayView<const UAbilityTagRelationshipMapping*> Layers)
+{
+	check(IsInGameThread());
+
+	CrimTagRelationshipLayers::FLayerKey Key;
+	for (const UAbilityTagRelationshipMapping* Layer : Layers)
+	{
+		if (Layer)
+		{
+			Key.Layers.Add(Layer);
+		}
+	}
+
+	if (Key.Layers.IsEmpty())
+	{
+		return nullptr;
+	}
+
+	if (const TWeakPtr<const FAbilityTagRelationshipTable>* MergedTable = CrimTagRelationshipLayers::MergedTables.Find(Key))
+	{
+		if (TSharedPtr<const FAbilityTagRelationshipTable> Table = MergedTable->Pin())
+		{
+			return Table;
+		}
+	}
+
+	TSharedRef<FAbilityTagRelationshipTable> Table = MakeShared<FAbilityTagRelationshipTable>();
+	for (const UAbilityTagRelationshipMapping* Layer : Layers)
 	{
-		const FAbilityTagRelationship& Tags = AbilityTagRelationships[i];
+		if (Layer)
+		{
+			Table->Merge(Layer->GetCompiledTable());
+		}
+	}
+	Table->Entries.Compact();
 
-		if (Tags.AbilityTag == ActionTag && Tags.AbilityTagsToCancel.HasAny(AbilityTags))
+	// Drop the stacks nothing uses anymore before adding the new one.
+	for (auto It = CrimTagRelationshipLayers::MergedTables.CreateIterator(); It; ++It)
+	{
+		if (!It.Value().IsValid())
 		{
-			return true;
+			It.RemoveCurrent();
 		}
 	}
+	CrimTagRelationshipLayers::MergedTables.Add(MoveTemp(Key), Table);
+	return Table;
+}
 
-	return false;
+uint32 UAbilityTagRelationshipMapping::GetMappingGeneration()
+{
+	return CrimTagRelationshipLayers::MappingGeneration;
 }
@@ -5,6 +5,7 @@
 
 #include "CrimAbilityLogChannels.h"
 #include "CrimAbilitySystemComponent.h"
+#include "CrimGlobalAbilitySystem.h"
 #include "AbilityGameplayTags.h"
 #include "GameplayEffectExtension.h"
 #include "Attribute/HitPointsAttributeSet.h"
@@ -176,8 +177,23 @@ void UHitPointsComponent::FinishRevive()
 	MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, DeathState, this);
 }
 
+void UHitPointsComponent::OnRegister()
+{
+	Super::OnRegister();
+
+	if (UCrimGlobalAbilitySystem* GlobalAbilitySystem = UWorld::GetSubsystem<UCrimGlobalAbilitySystem>(GetWorld()))
+	{
+		GlobalAbilitySystem->RegisterAbilitySystemInterfaceComponent(this);
+	}
+}
+
 void UHitPointsComponent::OnUnregister()
 {
+	if (UCrimGlobalAbilitySystem* GlobalAbilitySystem = UWorld::GetSubsystem<UCrimGlobalAbilitySystem>(GetWorld()))
+	{
+		GlobalAbilitySystem->UnregisterAbilitySystemInterfaceComponent(this);
+	}
+
 	UninitializeFromAbilitySystem();
 	Super::OnUnregister();
 }
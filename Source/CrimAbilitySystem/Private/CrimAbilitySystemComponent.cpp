@@ -8,6 +8,15 @@
 #include "CrimAbilityLogChannels.h"
 #include "CrimGlobalAbilitySystem.h"
 #include "AbilityTagRelationshipMapping.h"
+#include "AbilityInteractionMatrix.h"
+#include "GameplayEffect.h"
+#include "Ability/Cost/AbilityCost.h"
+#include "Ability/Cost/AbilityCost_Charges.h"
+#include "Async/ParallelFor.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameplayTagsManager.h"
+#include "Net/UnrealNetwork.h"
+#include "TimerManager.h"
 
 
 UCrimAbilitySystemComponent::UCrimAbilitySystemComponent()
@@ -15,6 +24,22 @@ UCrimAbilitySystemComponent::UCrimAbilitySystemComponent()
 	FMemory::Memset(ActivationGroupCounts, 0, sizeof(ActivationGroupCounts));
 }
 
+void UCrimAbilitySystemComponent::PostInitProperties()
+{
+	Super::PostInitProperties();
+
+	// Registered after the properties were initialized from the archetype, which would otherwise point them at the template.
+	NativeCooldowns.RegisterWithOwner(this);
+	AbilityCharges.RegisterWithOwner(this);
+
+	// BlockAbilitiesWithTags and UnBlockAbilitiesWithTags aren't virtual, gameplay effects and other callers block
+	// abilities through them directly.
+	if (!HasAnyFlags(RF_ClassDefaultObject | RF_ArchetypeObject))
+	{
+		BlockedAbilityTags.RegisterGenericGameplayEvent().AddUObject(this, &ThisClass::HandleBlockedAbilityTagChanged);
+	}
+}
+
 void UCrimAbilitySystemComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
 	if (UCrimGlobalAbilitySystem* GlobalAbilitySystem = UWorld::GetSubsystem<UCrimGlobalAbilitySystem>(GetWorld()))
@@ -25,6 +50,22 @@ void UCrimAbilitySystemComponent::EndPlay(const EEndPlayReason::Type EndPlayReas
 	Super::EndPlay(EndPlayReason);
 }
 
+void UCrimAbilitySystemComponent::GetLifetimeReplicatedProps(TArray<class FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(ThisClass, NativeCooldowns, Params);
+
+	FDoRepLifetimeParams OwnerOnlyParams;
+	OwnerOnlyParams.bIsPushBased = true;
+	OwnerOnlyParams.Condition = COND_OwnerOnly;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(ThisClass, AbilityCharges, OwnerOnlyParams);
+}
+
 void UCrimAbilitySystemComponent::InitAbilityActorInfo(AActor* InOwnerActor, AActor* InAvatarActor)
 {
 	FGameplayAbilityActorInfo* ActorInfo = AbilityActorInfo.Get();
@@ -33,23 +74,41 @@ void UCrimAbilitySystemComponent::InitAbilityActorInfo(AActor* InOwnerActor, AAc
 
 	Super::InitAbilityActorInfo(InOwnerActor, InAvatarActor);
 	
-	if (UCrimGlobalAbilitySystem* GlobalAbilitySystem = UWorld::GetSubsystem<UCrimGlobalAbilitySystem>(GetWorld()))
+	UCrimGlobalAbilitySystem* GlobalAbilitySystem = UWorld::GetSubsystem<UCrimGlobalAbilitySystem>(GetWorld());
+	if (GlobalAbilitySystem)
 	{
 		GlobalAbilitySystem->RegisterAbilitySystemComponent(this);
 	}
 
-	TArray<UActorComponent*> ActorComponents = InOwnerActor->GetComponentsByInterface(UCrimAbilitySystemInterface::StaticClass());
-	for (UActorComponent*& Component : ActorComponents)
+	auto InitializeComponent = [this](UActorComponent* Component)
 	{
 		ICrimAbilitySystemInterface::Execute_InitializeWithAbilitySystem(Component, this);
-	}
+	};
 
-	if (InOwnerActor != InAvatarActor)
+	if (GlobalAbilitySystem)
+	{
+		// Walks the cached interface components, the actors are only scanned the first time they are initialized.
+		GlobalAbilitySystem->ForEachAbilitySystemInterfaceComponent(InOwnerActor, InitializeComponent);
+		if (InOwnerActor != InAvatarActor)
+		{
+			GlobalAbilitySystem->ForEachAbilitySystemInterfaceComponent(InAvatarActor, InitializeComponent);
+		}
+	}
+	else
 	{
-		ActorComponents = InAvatarActor->GetComponentsByInterface(UCrimAbilitySystemInterface::StaticClass());
+		TArray<UActorComponent*> ActorComponents = InOwnerActor->GetComponentsByInterface(UCrimAbilitySystemInterface::StaticClass());
 		for (UActorComponent*& Component : ActorComponents)
 		{
-			ICrimAbilitySystemInterface::Execute_InitializeWithAbilitySystem(Component, this);
+			InitializeComponent(Component);
+		}
+
+		if (InAvatarActor && InOwnerActor != InAvatarActor)
+		{
+			ActorComponents = InAvatarActor->GetComponentsByInterface(UCrimAbilitySystemInterface::StaticClass());
+			for (UActorComponent*& Component : ActorComponents)
+			{
+				InitializeComponent(Component);
+			}
 		}
 	}
 
@@ -58,54 +117,99 @@ void UCrimAbilitySystemComponent::InitAbilityActorInfo(AActor* InOwnerActor, AAc
 
 void UCrimAbilitySystemComponent::CancelAbilitiesByFunc(TShouldCancelAbilityFunc ShouldCancelFunc, bool bReplicateCancelAbility)
 {
+	for (const FCrimActiveAbility& ActiveAbility : ActiveNonCrimAbilities)
+	{
+		UE_LOG(LogCrimAbilitySystem, Error, TEXT("CancelAbilitiesByFunc: Non-CrimGameplayAbility %s was Granted to ASC. Skipping."), *GetNameSafe(ActiveAbility.Ability.Get()));
+	}
+
+	for (TArray<FCrimActiveAbility>& GroupAbilities : ActiveAbilitiesByGroup)
+	{
+		// Walk backwards without copying the group. Canceling swaps the last running ability into the removed slot, so only
+		// visited ones move. Clamp the index in case a cancel ended more than one ability.
+		for (int32 Index = GroupAbilities.Num() - 1; Index >= 0; Index = FMath::Min(Index - 1, GroupAbilities.Num() - 1))
+		{
+			const FCrimActiveAbility ActiveAbility = GroupAbilities[Index];
+			const UCrimGameplayAbility* CrimAbility = Cast<UCrimGameplayAbility>(ActiveAbility.Ability.Get());
+			if (CrimAbility && ShouldCancelFunc(CrimAbility, ActiveAbility.Handle))
+			{
+				CancelActiveAbility(ActiveAbility, bReplicateCancelAbility);
+			}
+		}
+	}
+}
+
+void UCrimAbilitySystemComponent::CancelAbilities(const FGameplayTagContainer* WithTags, const FGameplayTagContainer* WithoutTags, UGameplayAbility* Ignore)
+{
+	if (!WithTags)
+	{
+		// Without a tag filter every active ability is a candidate.
+		Super::CancelAbilities(WithTags, WithoutTags, Ignore);
+		return;
+	}
+
+	// The registry is keyed by AssetTags and their parents, so this matches AssetTags.HasAny(WithTags).
+	TArray<FGameplayAbilitySpecHandle, TInlineAllocator<8>> HandlesToCancel;
+	for (const FGameplayTag& Tag : *WithTags)
+	{
+		if (const TArray<FCrimActiveAbility>* ActiveAbilities = ActiveAbilitiesByTag.Find(Tag))
+		{
+			for (const FCrimActiveAbility& ActiveAbility : *ActiveAbilities)
+			{
+				HandlesToCancel.AddUnique(ActiveAbility.Handle);
+			}
+		}
+	}
+
 	ABILITYLIST_SCOPE_LOCK();
-	for (const FGameplayAbilitySpec& AbilitySpec : ActivatableAbilities.Items)
+	for (const FGameplayAbilitySpecHandle& Handle : HandlesToCancel)
 	{
-		if (!AbilitySpec.IsActive())
+		FGameplayAbilitySpec* AbilitySpec = GetAbilitySpecByHandle(Handle);
+		if (!AbilitySpec || !AbilitySpec->Ability || !AbilitySpec->IsActive())
 		{
 			continue;
 		}
 
-		UCrimGameplayAbility* CrimAbilityCDO = Cast<UCrimGameplayAbility>(AbilitySpec.Ability);
-		if (!CrimAbilityCDO)
+		if (WithoutTags && AbilitySpec->Ability->GetAssetTags().HasAny(*WithoutTags))
 		{
-			UE_LOG(LogCrimAbilitySystem, Error, TEXT("CancelAbilitiesByFunc: Non-CrimGameplayAbility %s was Granted to ASC. Skipping."), *AbilitySpec.Ability.GetName());
 			continue;
 		}
 
-		if (CrimAbilityCDO->GetInstancingPolicy() == EGameplayAbilityInstancingPolicy::InstancedPerActor ||
-			CrimAbilityCDO->GetInstancingPolicy() == EGameplayAbilityInstancingPolicy::InstancedPerExecution)
+		CancelAbilitySpec(*AbilitySpec, Ignore);
+	}
+}
+
+void UCrimAbilitySystemComponent::CancelActiveAbility(const FCrimActiveAbility& ActiveAbility, bool bReplicateCancelAbility)
+{
+	UGameplayAbility* Ability = ActiveAbility.Ability.Get();
+	const FGameplayAbilitySpec* AbilitySpec = GetAbilitySpecByHandle(ActiveAbility.Handle);
+	if (!Ability || !AbilitySpec)
+	{
+		return;
+	}
+
+	if (Ability->IsInstantiated())
+	{
+		// An earlier cancel may have already ended this instance.
+		if (!Ability->IsActive())
 		{
-			// Cancel all the spawned instances, not the CDO.
-			TArray<UGameplayAbility*> Instances = AbilitySpec.GetAbilityInstances();
-			for (UGameplayAbility* AbilityInstance : Instances)
-			{
-				UCrimGameplayAbility* CrimAbilityInstance = CastChecked<UCrimGameplayAbility>(AbilityInstance);
+			return;
+		}
 
-				if (ShouldCancelFunc(CrimAbilityInstance, AbilitySpec.Handle))
-				{
-					if (CrimAbilityInstance->CanBeCanceled())
-					{
-						CrimAbilityInstance->CancelAbility(AbilitySpec.Handle, AbilityActorInfo.Get(), CrimAbilityInstance->GetCurrentActivationInfo(), bReplicateCancelAbility);
-					}
-					else
-					{
-						UE_LOG(LogCrimAbilitySystem, Error, TEXT("CancelAbilitiesByFunc: Can't cancel ability [%s] because CanBeCanceled is false."), *CrimAbilityInstance->GetName());
-					}
-				}
-			}
+		if (Ability->CanBeCanceled())
+		{
+			Ability->CancelAbility(ActiveAbility.Handle, AbilityActorInfo.Get(), Ability->GetCurrentActivationInfo(), bReplicateCancelAbility);
 		}
 		else
 		{
-			// Cancel the non-instanced ability CDO.
-			if (ShouldCancelFunc(CrimAbilityCDO, AbilitySpec.Handle))
-			{
-				// Non-instanced abilities can always be canceled.
-				check(CrimAbilityCDO->CanBeCanceled());
-				CrimAbilityCDO->CancelAbility(AbilitySpec.Handle, AbilityActorInfo.Get(), FGameplayAbilityActivationInfo(), bReplicateCancelAbility);
-			}
+			UE_LOG(LogCrimAbilitySystem, Error, TEXT("CancelAbilitiesByFunc: Can't cancel ability [%s] because CanBeCanceled is false."), *Ability->GetName());
 		}
 	}
+	else if (AbilitySpec->IsActive())
+	{
+		// Non-instanced abilities can always be canceled.
+		check(Ability->CanBeCanceled());
+		Ability->CancelAbility(ActiveAbility.Handle, AbilityActorInfo.Get(), FGameplayAbilityActivationInfo(), bReplicateCancelAbility);
+	}
 }
 
 bool UCrimAbilitySystemComponent::IsActivationGroupBlocked(EAbilityActivationGroup Group) const
@@ -133,12 +237,24 @@ bool UCrimAbilitySystemComponent::IsActivationGroupBlocked(EAbilityActivationGro
 	return bBlocked;
 }
 
-void UCrimAbilitySystemComponent::AddAbilityToActivationGroup(EAbilityActivationGroup Group, UCrimGameplayAbility* CrimAbility)
+void UCrimAbilitySystemComponent::AddAbilityToActivationGroup(EAbilityActivationGroup Group, UCrimGameplayAbility* CrimAbility, FGameplayAbilitySpecHandle Handle)
 {
 	check(CrimAbility);
 	check(ActivationGroupCounts[(uint8)Group] < INT32_MAX);
 
 	ActivationGroupCounts[(uint8)Group]++;
+	ActiveAbilitiesByGroup[(uint8)Group].Add({CrimAbility, Handle});
+
+	if (Group == EAbilityActivationGroup::Exclusive_Blocking)
+	{
+		for (TPair<FGameplayAbilitySpecHandle, FCrimAbilityAvailability>& Pair : AbilityAvailability)
+		{
+			if (Pair.Value.bExclusive)
+			{
+				MarkAbilityAvailabilityDirty(Pair.Value);
+			}
+		}
+	}
 
 	const bool bReplicateCancelAbility = false;
 
@@ -165,288 +281,1794 @@ void UCrimAbilitySystemComponent::AddAbilityToActivationGroup(EAbilityActivation
 	}
 }
 
-void UCrimAbilitySystemComponent::RemoveAbilityFromActivationGroup(EAbilityActivationGroup Group, UCrimGameplayAbility* CrimAbility)
+void UCrimAbilitySystemComponent::RemoveAbilityFromActivationGroup(EAbilityActivationGroup Group, UCrimGameplayAbility* CrimAbility, FGameplayAbilitySpecHandle Handle)
 {
 	check(CrimAbility);
 	check(ActivationGroupCounts[(uint8)Group] > 0);
 
 	ActivationGroupCounts[(uint8)Group]--;
-}
+	ActiveAbilitiesByGroup[(uint8)Group].RemoveSingleSwap({CrimAbility, Handle});
 
-void UCrimAbilitySystemComponent::CancelActivationGroupAbilities(EAbilityActivationGroup Group, UCrimGameplayAbility* IgnoreCrimAbility, bool bReplicateCancelAbility)
-{
-	auto ShouldCancelFunc = [this, Group, IgnoreCrimAbility](const UCrimGameplayAbility* CrimAbility, FGameplayAbilitySpecHandle Handle)
+	if (Group == EAbilityActivationGroup::Exclusive_Blocking)
 	{
-		return ((CrimAbility->GetActivationGroup() == Group) && (CrimAbility != IgnoreCrimAbility));
-	};
-
-	CancelAbilitiesByFunc(ShouldCancelFunc, bReplicateCancelAbility);
+		for (TPair<FGameplayAbilitySpecHandle, FCrimAbilityAvailability>& Pair : AbilityAvailability)
+		{
+			if (Pair.Value.bExclusive)
+			{
+				MarkAbilityAvailabilityDirty(Pair.Value);
+			}
+		}
+	}
 }
 
-void UCrimAbilitySystemComponent::GetAbilityTargetData(const FGameplayAbilitySpecHandle AbilityHandle, FGameplayAbilityActivationInfo ActivationInfo, FGameplayAbilityTargetDataHandle& OutTargetDataHandle)
+bool UCrimAbilitySystemComponent::IsAbilitySpecRunningInActivationGroup(FGameplayAbilitySpecHandle Handle, EAbilityActivationGroup Group) const
 {
-	TSharedPtr<FAbilityReplicatedDataCache> ReplicatedData = AbilityTargetDataMap.Find(FGameplayAbilitySpecHandleAndPredictionKey(AbilityHandle, ActivationInfo.GetActivationPredictionKey()));
-	if (ReplicatedData.IsValid())
+	return ActiveAbilitiesByGroup[(uint8)Group].ContainsByPredicate([Handle](const FCrimActiveAbility& ActiveAbility)
 	{
-		OutTargetDataHandle = ReplicatedData->TargetData;
-	}
+		return ActiveAbility.Handle == Handle;
+	});
 }
 
-void UCrimAbilitySystemComponent::SetTagRelationshipMapping(UAbilityTagRelationshipMapping* NewMapping)
+void UCrimAbilitySystemComponent::CancelActivationGroupAbilities(EAbilityActivationGroup Group, UCrimGameplayAbility* IgnoreCrimAbility, bool bReplicateCancelAbility)
 {
-	TagRelationshipMapping = NewMapping;
+	// Copy the group since canceling removes abilities from it.
+	const TArray<FCrimActiveAbility, TInlineAllocator<4>> GroupAbilities(ActiveAbilitiesByGroup[(uint8)Group]);
+	for (const FCrimActiveAbility& ActiveAbility : GroupAbilities)
+	{
+		if (ActiveAbility.Ability != IgnoreCrimAbility)
+		{
+			CancelActiveAbility(ActiveAbility, bReplicateCancelAbility);
+		}
+	}
 }
 
-void UCrimAbilitySystemComponent::GetAdditionalActivationTagRequirements(const FGameplayTagContainer& AbilityTags, FGameplayTagContainer& OutActivationRequired, FGameplayTagContainer& OutActivationBlocked) const
+void UCrimAbilitySystemComponent::GiveAbilities(TArrayView<const FGameplayAbilitySpec> AbilitySpecs, TArray<FGameplayAbilitySpecHandle>* OutHandles)
 {
-	if (TagRelationshipMapping)
+	if (!IsOwnerActorAuthoritative())
 	{
-		TagRelationshipMapping->GetRequiredAndBlockedActivationTags(AbilityTags, &OutActivationRequired, &OutActivationBlocked);
+		UE_LOG(LogCrimAbilitySystem, Error, TEXT("GiveAbilities: Called on [%s] without authority."), *GetNameSafe(GetOwner()));
+		return;
 	}
-}
 
-FGameplayAbilitySpec* UCrimAbilitySystemComponent::GetAbilitySpecWithAbilityTag(const FGameplayTag& AbilityTag)
-{
-	if (AbilityTag.IsValid())
+	if (AbilityScopeLockCount > 0)
 	{
-		FScopedAbilityListLock ActiveScopeLoc(*this);
-		for (FGameplayAbilitySpec& AbilitySpec : GetActivatableAbilities())
+		// GiveAbility defers the grants until the ability list is unlocked, they are given and notified one by one then.
+		for (const FGameplayAbilitySpec& AbilitySpec : AbilitySpecs)
 		{
-			if (AbilitySpec.Ability.Get()->GetAssetTags().HasTag(AbilityTag))
+			const FGameplayAbilitySpecHandle Handle = GiveAbility(AbilitySpec);
+			if (OutHandles)
 			{
-				return &AbilitySpec;
+				OutHandles->Add(Handle);
 			}
 		}
+		return;
 	}
-	return nullptr;
-}
 
-void UCrimAbilitySystemComponent::GetAllAbilitySpecsWithAbilityTag(const FGameplayTag& AbilityTag, TArray<FGameplayAbilitySpec*>& OutAbilitySpecs)
-{
-	OutAbilitySpecs.Empty();
-	if (AbilityTag.IsValid())
+	TArray<FGameplayAbilitySpecHandle, TInlineAllocator<16>> GivenHandles;
 	{
-		FScopedAbilityListLock ActiveScopeLoc(*this);
-		for (FGameplayAbilitySpec& AbilitySpec : GetActivatableAbilities())
+		TGuardValue<bool> BatchGuard(bIsProcessingAbilityBatch, true);
+		ABILITYLIST_SCOPE_LOCK();
+
+		ActivatableAbilities.Items.Reserve(ActivatableAbilities.Items.Num() + AbilitySpecs.Num());
+		for (const FGameplayAbilitySpec& AbilitySpec : AbilitySpecs)
 		{
-			if (AbilitySpec.Ability.Get()->GetAssetTags().HasTag(AbilityTag))
+			if (!IsValid(AbilitySpec.Ability))
+			{
+				UE_LOG(LogCrimAbilitySystem, Error, TEXT("GiveAbilities: Skipped an invalid ability for [%s]."), *GetNameSafe(GetOwner()));
+				if (OutHandles)
+				{
+					OutHandles->Add(FGameplayAbilitySpecHandle());
+				}
+				continue;
+			}
+
+			// The same steps as GiveAbility, except the spec is not marked dirty on its own.
+			FGameplayAbilitySpec& OwnedSpec = ActivatableAbilities.Items[ActivatableAbilities.Items.Add(AbilitySpec)];
+			if (OwnedSpec.Ability->GetInstancingPolicy() == EGameplayAbilityInstancingPolicy::InstancedPerActor)
 			{
-				OutAbilitySpecs.Add(&AbilitySpec);
+				CreateNewInstanceOfAbility(OwnedSpec, AbilitySpec.Ability);
+			}
+
+			OnGiveAbility(OwnedSpec);
+			AbilitySpecDirtiedCallbacks.Broadcast(OwnedSpec);
+
+			GivenHandles.Add(OwnedSpec.Handle);
+			if (OutHandles)
+			{
+				OutHandles->Add(OwnedSpec.Handle);
 			}
 		}
+
+		// The new items have no replication ID yet, the whole batch is assigned and sent in the next replication update.
+		if (!GivenHandles.IsEmpty())
+		{
+			ActivatableAbilities.MarkArrayDirty();
+		}
 	}
-}
 
-FGameplayAbilitySpec* UCrimAbilitySystemComponent::GetAbilitySpecWithDynamicTag(const FGameplayTag& DynamicTag)
-{
-	if (DynamicTag.IsValid())
+	// Includes the abilities that were given while the batch held the ability list lock.
+	const TArray<FGameplayAbilitySpecHandle> BatchGivenHandles = MoveTemp(BatchGivenAbilitySpecHandles);
+	BatchGivenAbilitySpecHandles.Reset();
+
+	// Activate the OnSpawn abilities once the whole batch is granted so they can see each other.
 	{
-		FScopedAbilityListLock ActiveScopeLoc(*this);
-		for (FGameplayAbilitySpec& AbilitySpec : GetActivatableAbilities())
+		ABILITYLIST_SCOPE_LOCK();
+		for (const FGameplayAbilitySpecHandle& Handle : BatchGivenHandles)
 		{
-			if (AbilitySpec.GetDynamicSpecSourceTags().HasTag(DynamicTag))
+			if (!OnSpawnAbilitySpecHandles.Contains(Handle))
 			{
-				return &AbilitySpec;
+				continue;
+			}
+
+			if (const FGameplayAbilitySpec* AbilitySpec = GetAbilitySpecByHandle(Handle))
+			{
+				CastChecked<UCrimGameplayAbility>(AbilitySpec->Ability)->TryActivateAbilityOnSpawn(AbilityActorInfo.Get(), *AbilitySpec);
 			}
 		}
 	}
-	return nullptr;
-}
 
-void UCrimAbilitySystemComponent::GetAllAbilitySpecsWithDynamicTag(const FGameplayTag& DynamicTag, TArray<FGameplayAbilitySpec*>& OutAbilitySpecs)
-{
-	OutAbilitySpecs.Empty();
-	if (DynamicTag.IsValid())
+	for (const FGameplayAbilitySpecHandle& Handle : BatchGivenHandles)
 	{
-		FScopedAbilityListLock ActiveScopeLoc(*this);
-		for (FGameplayAbilitySpec& AbilitySpec : GetActivatableAbilities())
+		if (const FGameplayAbilitySpec* AbilitySpec = GetAbilitySpecByHandle(Handle))
 		{
-			if (AbilitySpec.GetDynamicSpecSourceTags().HasTag(DynamicTag))
-			{
-				OutAbilitySpecs.Add(&AbilitySpec);
-			}
+			OnAbilityGivenDelegate.Broadcast(this, *AbilitySpec);
 		}
 	}
+
+	if (!GivenHandles.IsEmpty())
+	{
+		OnAbilitiesGivenDelegate.Broadcast(this, GivenHandles);
+	}
 }
 
-FGameplayAbilitySpec* UCrimAbilitySystemComponent::GetAbilitySpecByClass(TSubclassOf<UGameplayAbility> AbilityClass)
+void UCrimAbilitySystemComponent::ClearAbilities(TArrayView<const FGameplayAbilitySpecHandle> Handles)
 {
-	if (AbilityClass)
+	if (!IsOwnerActorAuthoritative())
+	{
+		UE_LOG(LogCrimAbilitySystem, Error, TEXT("ClearAbilities: Called on [%s] without authority."), *GetNameSafe(GetOwner()));
+		return;
+	}
+
+	if (AbilityScopeLockCount > 0)
 	{
-		const UGameplayAbility* const InAbilityCDO = AbilityClass.GetDefaultObject();
-		FScopedAbilityListLock ActiveScopeLoc(*this);
-		for (FGameplayAbilitySpec& AbilitySpec : GetActivatableAbilities())
+		// ClearAbility defers the removals until the ability list is unlocked, OnAbilitiesRemovedDelegate waits for them.
+		for (const FGameplayAbilitySpecHandle& Handle : Handles)
 		{
-			if (AbilitySpec.Ability == InAbilityCDO)
+			if (Handle.IsValid() && GetAbilitySpecByHandle(Handle))
 			{
-				return &AbilitySpec;
+				ClearAbility(Handle);
+				DeferredClearedAbilityHandles.AddUnique(Handle);
 			}
 		}
+		ScheduleDeferredClearedAbilitiesBroadcast();
+		return;
 	}
-	return nullptr;
-}
 
-void UCrimAbilitySystemComponent::GetAllAbilitySpecsByClass(TSubclassOf<UGameplayAbility> AbilityClass, TArray<FGameplayAbilitySpec*>& OutAbilitySpecs)
-{
-	OutAbilitySpecs.Empty();
-	if (AbilityClass)
+	TSet<FGameplayAbilitySpecHandle> HandlesToClear;
+	HandlesToClear.Reserve(Handles.Num());
+	for (const FGameplayAbilitySpecHandle& Handle : Handles)
 	{
-		const UGameplayAbility* const InAbilityCDO = AbilityClass.GetDefaultObject();
-		FScopedAbilityListLock ActiveScopeLoc(*this);
-		for (FGameplayAbilitySpec& AbilitySpec : GetActivatableAbilities())
+		if (Handle.IsValid())
 		{
-			if (AbilitySpec.Ability == InAbilityCDO)
-			{
-				OutAbilitySpecs.Add(&AbilitySpec);
-			}
+			HandlesToClear.Add(Handle);
 		}
 	}
-}
 
-void UCrimAbilitySystemComponent::AddDynamicTagToAbilitySpec(FGameplayAbilitySpec* AbilitySpec, const FGameplayTag& DynamicTag)
-{
-	if (!GetOwner()->HasAuthority())
+	TArray<FGameplayAbilitySpecHandle, TInlineAllocator<16>> ClearedHandles;
 	{
-		return;
+		TGuardValue<bool> BatchGuard(bIsProcessingAbilityBatch, true);
+
+		// OnRemoveAbility can end abilities, which can clear or give abilities again. The lock defers those.
+		ABILITYLIST_SCOPE_LOCK();
+
+		TArray<int32, TInlineAllocator<16>> RemovedIndices;
+		for (int32 Idx = 0; Idx < ActivatableAbilities.Items.Num() && RemovedIndices.Num() < HandlesToClear.Num(); ++Idx)
+		{
+			if (HandlesToClear.Contains(ActivatableAbilities.Items[Idx].Handle))
+			{
+				RemovedIndices.Add(Idx);
+			}
+		}
+
+		// Removing from the back keeps the remaining indices valid, each swap only moves a spec from behind them. This is
+		// also the order OnRemoveAbility expects when it patches the handle index.
+		for (int32 i = RemovedIndices.Num() - 1; i >= 0; --i)
+		{
+			const int32 Idx = RemovedIndices[i];
+			ClearedHandles.Add(ActivatableAbilities.Items[Idx].Handle);
+			OnRemoveAbility(ActivatableAbilities.Items[Idx]);
+			ActivatableAbilities.Items.RemoveAtSwap(Idx, 1, EAllowShrinking::No);
+		}
+
+		if (!ClearedHandles.IsEmpty())
+		{
+			ActivatableAbilities.MarkArrayDirty();
+		}
 	}
-	
-	if (!AbilitySpec)
+
+	if (!ClearedHandles.IsEmpty())
 	{
-		return;
+		CheckForClearedAbilities();
 	}
 
-	if (AbilitySpec->GetDynamicSpecSourceTags().HasTag(DynamicTag))
+	const TArray<FGameplayAbilitySpec> BatchRemovedSpecs = MoveTemp(BatchRemovedAbilitySpecs);
+	BatchRemovedAbilitySpecs.Reset();
+	for (const FGameplayAbilitySpec& AbilitySpec : BatchRemovedSpecs)
 	{
-		// Dynamic Spec Source tags already has the DynamicTag.
-		return;
+		OnAbilityRemovedDelegate.Broadcast(this, AbilitySpec);
 	}
 
-	TArray<FGameplayAbilitySpec*> OutSpecs;
-	GetAllAbilitySpecsWithDynamicTag(DynamicTag, OutSpecs);
-	for (FGameplayAbilitySpec*& Spec : OutSpecs)
+	if (!ClearedHandles.IsEmpty())
 	{
-		Spec->GetDynamicSpecSourceTags().RemoveTag(DynamicTag);
-		MarkAbilitySpecDirty(*Spec);
+		OnAbilitiesRemovedDelegate.Broadcast(this, ClearedHandles);
 	}
-	
-	AbilitySpec->GetDynamicSpecSourceTags().AddTag(DynamicTag);
-	MarkAbilitySpecDirty(*AbilitySpec);
 }
 
-void UCrimAbilitySystemComponent::RemoveDynamicTagFromAbilitySpec(FGameplayAbilitySpec* AbilitySpec, const FGameplayTag& DynamicTag)
+void UCrimAbilitySystemComponent::ScheduleDeferredClearedAbilitiesBroadcast()
 {
-	if (!GetOwner()->HasAuthority())
+	UWorld* World = GetWorld();
+	if (bDeferredClearedAbilitiesBroadcastPending || DeferredClearedAbilityHandles.IsEmpty() || !World)
 	{
 		return;
 	}
-	
-	if (!AbilitySpec)
+
+	bDeferredClearedAbilitiesBroadcastPending = true;
+	World->GetTimerManager().SetTimerForNextTick(FTimerDelegate::CreateUObject(this, &ThisClass::BroadcastDeferredClearedAbilities));
+}
+
+void UCrimAbilitySystemComponent::BroadcastDeferredClearedAbilities()
+{
+	bDeferredClearedAbilitiesBroadcastPending = false;
+
+	if (AbilityScopeLockCount > 0)
 	{
+		// The removals have not run yet.
+		ScheduleDeferredClearedAbilitiesBroadcast();
 		return;
 	}
 
-	if (!AbilitySpec->GetDynamicSpecSourceTags().HasTag(DynamicTag))
+	TArray<FGameplayAbilitySpecHandle> ClearedHandles = MoveTemp(DeferredClearedAbilityHandles);
+	DeferredClearedAbilityHandles.Reset();
+	ClearedHandles.RemoveAll([this](const FGameplayAbilitySpecHandle& Handle)
 	{
-		// Dynamic Spec Source tags already does not have the tag.
-		return;
-	}
+		return GetAbilitySpecByHandle(Handle) != nullptr;
+	});
 
-	AbilitySpec->GetDynamicSpecSourceTags().RemoveTag(DynamicTag);
-	MarkAbilitySpecDirty(*AbilitySpec);
+	if (!ClearedHandles.IsEmpty())
+	{
+		OnAbilitiesRemovedDelegate.Broadcast(this, ClearedHandles);
+	}
 }
 
-void UCrimAbilitySystemComponent::TryActivateAbilitiesOnSpawn()
+void UCrimAbilitySystemComponent::GetAbilityTargetData(const FGameplayAbilitySpecHandle AbilityHandle, FGameplayAbilityActivationInfo ActivationInfo, FGameplayAbilityTargetDataHandle& OutTargetDataHandle)
 {
-	ABILITYLIST_SCOPE_LOCK();
-	for (const FGameplayAbilitySpec& AbilitySpec : ActivatableAbilities.Items)
+	TSharedPtr<FAbilityReplicatedDataCache> ReplicatedData = AbilityTargetDataMap.Find(FGameplayAbilitySpecHandleAndPredictionKey(AbilityHandle, ActivationInfo.GetActivationPredictionKey()));
+	if (ReplicatedData.IsValid())
 	{
-		if (const UCrimGameplayAbility* CrimAbilityCDO = Cast<UCrimGameplayAbility>(AbilitySpec.Ability))
-		{
-			CrimAbilityCDO->TryActivateAbilityOnSpawn(AbilityActorInfo.Get(), AbilitySpec);
-		}
+		OutTargetDataHandle = ReplicatedData->TargetData;
 	}
 }
 
-void UCrimAbilitySystemComponent::AbilitySpecInputPressed(FGameplayAbilitySpec& Spec)
+void UCrimAbilitySystemComponent::SetTagRelationshipMapping(UAbilityTagRelationshipMapping* NewMapping)
 {
-	Super::AbilitySpecInputPressed(Spec);
-
-	// We don't support UGameplayAbility::bReplicateInputDirectly.
-	// Use replicated events instead so that the WaitInputPress ability task works.
-	if (Spec.IsActive())
+	if (TagRelationshipMapping != NewMapping)
 	{
-		// Invoke the InputPressed event. This is not replicated here. If someone is listening, they may replicate the InputPressed event to the server.
-		InvokeReplicatedEvent(EAbilityGenericReplicatedEvent::InputPressed,
-			Spec.Handle,
-			Spec.GetPrimaryInstance()->GetCurrentActivationInfo().GetActivationPredictionKey()
-		);
+		TagRelationshipMapping = NewMapping;
+		HandleTagRelationshipMappingChanged();
 	}
 }
 
-void UCrimAbilitySystemComponent::AbilitySpecInputReleased(FGameplayAbilitySpec& Spec)
+void UCrimAbilitySystemComponent::PushTagRelationshipMapping(UAbilityTagRelationshipMapping* Mapping)
 {
-	Super::AbilitySpecInputReleased(Spec);
-
-	// We don't support UGameplayAbility::bReplicateInputDirectly.
-	// Use replicated events instead so that the WaitInputRelease ability task works.
-	if (Spec.IsActive())
+	if (Mapping)
 	{
-		// Invoke the InputReleased event. This is not replicated here. If someone is listening, they may replicate the InputReleased event to the server.
-		InvokeReplicatedEvent(EAbilityGenericReplicatedEvent::InputReleased,
-			Spec.Handle,
-			Spec.GetPrimaryInstance()->GetCurrentActivationInfo().GetActivationPredictionKey()
-		);
+		TagRelationshipLayers.Add(Mapping);
+		HandleTagRelationshipMappingChanged();
 	}
 }
 
-void UCrimAbilitySystemComponent::NotifyAbilityActivated(const FGameplayAbilitySpecHandle Handle, UGameplayAbility* Ability)
+void UCrimAbilitySystemComponent::RemoveTagRelationshipMapping(UAbilityTagRelationshipMapping* Mapping)
 {
-	Super::NotifyAbilityActivated(Handle, Ability);
-	
-	if (UCrimGameplayAbility* CrimAbility = Cast<UCrimGameplayAbility>(Ability))
+	const int32 LayerIndex = TagRelationshipLayers.FindLast(Mapping);
+	if (LayerIndex != INDEX_NONE)
 	{
-		AddAbilityToActivationGroup(CrimAbility->GetActivationGroup(), CrimAbility);
+		TagRelationshipLayers.RemoveAt(LayerIndex);
+		HandleTagRelationshipMappingChanged();
 	}
 }
 
-void UCrimAbilitySystemComponent::NotifyAbilityFailed(const FGameplayAbilitySpecHandle Handle, UGameplayAbility* Ability, const FGameplayTagContainer& FailureReason)
+void UCrimAbilitySystemComponent::ApplyNativeCooldown(const FGameplayTagContainer& CooldownTags, float Duration, const FGameplayAbilityActivationInfo& ActivationInfo)
 {
-	if (APawn* Avatar = Cast<APawn>(GetAvatarActor()))
+	if (Duration <= 0.f || CooldownTags.IsEmpty())
 	{
-		if (!Avatar->IsLocallyControlled() && Ability->IsSupportedForNetworking())
-		{
-			ClientNotifyAbilityFailed(Ability, FailureReason);
-			return;
-		}
+		return;
 	}
 
-	HandleAbilityFailed(Ability, FailureReason);
-}
-
-void UCrimAbilitySystemComponent::NotifyAbilityEnded(FGameplayAbilitySpecHandle Handle, UGameplayAbility* Ability, bool bWasCancelled)
-{
-	Super::NotifyAbilityEnded(Handle, Ability, bWasCancelled);
+	const double EndTime = GetServerWorldTimeSeconds() + Duration;
 
-	if (UCrimGameplayAbility* CrimAbility = Cast<UCrimGameplayAbility>(Ability))
+	if (IsOwnerActorAuthoritative())
 	{
-		RemoveAbilityFromActivationGroup(CrimAbility->GetActivationGroup(), CrimAbility);
+		for (const FGameplayTag& CooldownTag : CooldownTags)
+		{
+			NativeCooldowns.SetCooldown(CooldownTag, EndTime, Duration);
+		}
+	}
+	else
+	{
+		for (const FGameplayTag& CooldownTag : CooldownTags)
+		{
+			FAbilityCooldownItem& Predicted = PredictedNativeCooldowns.FindOrAdd(CooldownTag);
+			Predicted.CooldownTag = CooldownTag;
+			Predicted.EndTime = EndTime;
+			Predicted.Duration = Duration;
+			RefreshNativeCooldownTag(CooldownTag);
+			OnNativeCooldownAppliedDelegate.Broadcast(this, CooldownTag, Duration, Duration);
+		}
+
+		// Roll back the predicted cooldowns if the server rejects the activation.
+		FPredictionKey PredictionKey = ActivationInfo.GetActivationPredictionKey();
+		if (PredictionKey.IsValidKey())
+		{
+			PredictionKey.NewRejectedDelegate().BindWeakLambda(this, [this, CooldownTags, EndTime]()
+			{
+				for (const FGameplayTag& CooldownTag : CooldownTags)
+				{
+					const FAbilityCooldownItem* Predicted = PredictedNativeCooldowns.Find(CooldownTag);
+					if (Predicted && Predicted->EndTime == EndTime)
+					{
+						PredictedNativeCooldowns.Remove(CooldownTag);
+						RefreshNativeCooldownTag(CooldownTag);
+					}
+				}
+			});
+		}
+	}
+
+	ScheduleNativeCooldownTimer();
+}
+
+bool UCrimAbilitySystemComponent::IsNativeCooldownActive(const FGameplayTagContainer& CooldownTags) const
+{
+	float TimeRemaining = 0.f;
+	float Duration = 0.f;
+	return GetNativeCooldownTimeRemainingAndDuration(CooldownTags, TimeRemaining, Duration);
+}
+
+bool UCrimAbilitySystemComponent::GetNativeCooldownTimeRemainingAndDuration(const FGameplayTagContainer& CooldownTags, float& OutTimeRemaining, float& OutDuration) const
+{
+	OutTimeRemaining = 0.f;
+	OutDuration = 0.f;
+
+	if (NativeCooldowns.GetItems().IsEmpty() && PredictedNativeCooldowns.IsEmpty())
+	{
+		return false;
+	}
+
+	const double Now = GetServerWorldTimeSeconds();
+	auto ConsiderCooldown = [Now, &OutTimeRemaining, &OutDuration](const FAbilityCooldownItem* Item)
+	{
+		if (Item && Item->EndTime - Now > OutTimeRemaining)
+		{
+			OutTimeRemaining = static_cast<float>(Item->EndTime - Now);
+			OutDuration = Item->Duration;
+		}
+	};
+
+	for (const FGameplayTag& CooldownTag : CooldownTags)
+	{
+		ConsiderCooldown(NativeCooldowns.FindCooldown(CooldownTag));
+		ConsiderCooldown(PredictedNativeCooldowns.Find(CooldownTag));
+	}
+	return OutTimeRemaining > 0.f;
+}
+
+int32 UCrimAbilitySystemComponent::GetAbilityCharges(FGameplayAbilitySpecHandle Handle, int32 MaxCharges) const
+{
+	const FAbilityChargeItem* Item = FindAbilityCharges(Handle);
+	return Item ? Item->GetCharges(GetServerWorldTimeSeconds(), MaxCharges) : MaxCharges;
+}
+
+float UCrimAbilitySystemComponent::GetAbilityChargeTimeRemaining(FGameplayAbilitySpecHandle Handle, int32 MaxCharges) const
+{
+	const FAbilityChargeItem* Item = FindAbilityCharges(Handle);
+	return Item ? Item->GetTimeUntilNextCharge(GetServerWorldTimeSeconds(), MaxCharges) : 0.f;
+}
+
+void UCrimAbilitySystemComponent::ConsumeAbilityCharges(FGameplayAbilitySpecHandle Handle, int32 Count, int32 MaxCharges, float RechargePeriod, const FGameplayAbilityActivationInfo& ActivationInfo)
+{
+	const double Now = GetServerWorldTimeSeconds();
+
+	if (IsOwnerActorAuthoritative())
+	{
+		AbilityCharges.Consume(Handle, Now, Count, MaxCharges, RechargePeriod);
+	}
+	else
+	{
+		// Predict from what this client currently sees.
+		FAbilityChargeItem Predicted;
+		if (const FAbilityChargeItem* Item = FindAbilityCharges(Handle))
+		{
+			Predicted = *Item;
+		}
+		else
+		{
+			Predicted.Handle = Handle;
+			Predicted.Charges = MaxCharges;
+			Predicted.RechargePeriod = RechargePeriod;
+		}
+		Predicted.Consume(Now, Count, MaxCharges, RechargePeriod);
+		PredictedAbilityCharges.Add(Handle, Predicted);
+
+		// Restore the charges if the server rejects the activation.
+		FPredictionKey PredictionKey = ActivationInfo.GetActivationPredictionKey();
+		if (PredictionKey.IsValidKey())
+		{
+			PredictionKey.NewRejectedDelegate().BindWeakLambda(this, [this, Handle, Predicted]()
+			{
+				const FAbilityChargeItem* Current = PredictedAbilityCharges.Find(Handle);
+				if (Current && Current->Charges == Predicted.Charges && Current->LastRefillTime == Predicted.LastRefillTime)
+				{
+					PredictedAbilityCharges.Remove(Handle);
+					MarkAbilityAvailabilityDirty(Handle);
+				}
+			});
+		}
+	}
+
+	InvalidateCostEvaluations();
+	ScheduleAbilityChargeRecheck(Handle);
+	MarkAbilityAvailabilityDirty(Handle);
+}
+
+void UCrimAbilitySystemComponent::OnAbilityChargesChanged(const FAbilityChargeItem& Item)
+{
+	// The server's charges replace the prediction.
+	PredictedAbilityCharges.Remove(Item.Handle);
+
+	InvalidateCostEvaluations();
+	ScheduleAbilityChargeRecheck(Item.Handle);
+	MarkAbilityAvailabilityDirty(Item.Handle);
+}
+
+const FAbilityChargeItem* UCrimAbilitySystemComponent::FindAbilityCharges(FGameplayAbilitySpecHandle Handle) const
+{
+	if (const FAbilityChargeItem* Predicted = PredictedAbilityCharges.Find(Handle))
+	{
+		return Predicted;
+	}
+	return AbilityCharges.Find(Handle);
+}
+
+void UCrimAbilitySystemComponent::ScheduleAbilityChargeRecheck(FGameplayAbilitySpecHandle Handle)
+{
+	UWorld* World = GetWorld();
+	if (!World)
+	{
+		return;
+	}
+
+	// Wait for the charge cost that takes the longest to be affordable.
+	float Delay = 0.f;
+	const FAbilityChargeItem* Item = FindAbilityCharges(Handle);
+	const FGameplayAbilitySpec* AbilitySpec = Item && AbilityAvailability.Contains(Handle) ? GetAbilitySpecByHandle(Handle) : nullptr;
+	if (const UCrimGameplayAbility* CrimAbilityCDO = AbilitySpec ? Cast<UCrimGameplayAbility>(AbilitySpec->Ability) : nullptr)
+	{
+		const double Now = GetServerWorldTimeSeconds();
+		for (const TObjectPtr<UAbilityCost>& AdditionalCost : CrimAbilityCDO->AdditionalCosts)
+		{
+			if (const UAbilityCost_Charges* ChargesCost = Cast<UAbilityCost_Charges>(AdditionalCost))
+			{
+				Delay = FMath::Max(Delay, Item->GetTimeUntilCharges(Now, ChargesCost->GetChargesPerUse(), ChargesCost->GetMaxCharges()));
+			}
+		}
+	}
+
+	if (Delay <= 0.f)
+	{
+		if (FTimerHandle* TimerHandle = AbilityChargeTimerHandles.Find(Handle))
+		{
+			World->GetTimerManager().ClearTimer(*TimerHandle);
+			AbilityChargeTimerHandles.Remove(Handle);
+		}
+		return;
+	}
+
+	// Re-arms itself in case the charges changed and still fall short when it fires.
+	World->GetTimerManager().SetTimer(AbilityChargeTimerHandles.FindOrAdd(Handle), FTimerDelegate::CreateWeakLambda(this, [this, Handle]()
+	{
+		AbilityChargeTimerHandles.Remove(Handle);
+		MarkAbilityAvailabilityDirty(Handle);
+		ScheduleAbilityChargeRecheck(Handle);
+	}), Delay, false);
+}
+
+FAbilityCostEvaluationContext* UCrimAbilitySystemComponent::GetCostEvaluationContext(FGameplayAbilitySpecHandle Handle) const
+{
+	if (!Handle.IsValid() || !IsInGameThread())
+	{
+		return nullptr;
+	}
+
+	FAbilityCostEvaluationContext& Context = CostEvaluationContexts.FindOrAdd(Handle);
+	if (Context.FrameCounter != GFrameCounter || Context.Generation != CostEvaluationGeneration)
+	{
+		Context.Reset(GFrameCounter, CostEvaluationGeneration);
+	}
+	return &Context;
+}
+
+void UCrimAbilitySystemComponent::InvalidateCostEvaluations()
+{
+	++CostEvaluationGeneration;
+}
+
+double UCrimAbilitySystemComponent::GetServerWorldTimeSeconds() const
+{
+	const UWorld* World = GetWorld();
+	if (!World)
+	{
+		return 0.0;
+	}
+
+	if (const AGameStateBase* GameState = World->GetGameState())
+	{
+		return GameState->GetServerWorldTimeSeconds();
+	}
+	return World->GetTimeSeconds();
+}
+
+void UCrimAbilitySystemComponent::OnNativeCooldownChanged(const FAbilityCooldownItem& Item)
+{
+	// The server's cooldown replaces the prediction.
+	PredictedNativeCooldowns.Remove(Item.CooldownTag);
+
+	RefreshNativeCooldownTag(Item.CooldownTag);
+	ScheduleNativeCooldownTimer();
+
+	OnNativeCooldownAppliedDelegate.Broadcast(this, Item.CooldownTag, static_cast<float>(FMath::Max(Item.EndTime - GetServerWorldTimeSeconds(), 0.0)), Item.Duration);
+}
+
+void UCrimAbilitySystemComponent::OnNativeCooldownRemoved(const FAbilityCooldownItem& Item)
+{
+	RefreshNativeCooldownTag(Item.CooldownTag, &Item);
+}
+
+void UCrimAbilitySystemComponent::RefreshNativeCooldownTag(const FGameplayTag& CooldownTag, const FAbilityCooldownItem* IgnoreItem)
+{
+	const double Now = GetServerWorldTimeSeconds();
+
+	bool bOnCooldown = false;
+	const FAbilityCooldownItem* Item = NativeCooldowns.FindCooldown(CooldownTag);
+	if (Item && Item != IgnoreItem && Item->EndTime > Now)
+	{
+		bOnCooldown = true;
+	}
+	const FAbilityCooldownItem* Predicted = PredictedNativeCooldowns.Find(CooldownTag);
+	if (Predicted && Predicted->EndTime > Now)
+	{
+		bOnCooldown = true;
+	}
+
+	if (bOnCooldown && !GrantedNativeCooldownTags.Contains(CooldownTag))
+	{
+		GrantedNativeCooldownTags.Add(CooldownTag);
+		AddLooseGameplayTag(CooldownTag);
+	}
+	else if (!bOnCooldown && GrantedNativeCooldownTags.Remove(CooldownTag) > 0)
+	{
+		RemoveLooseGameplayTag(CooldownTag);
+	}
+}
+
+void UCrimAbilitySystemComponent::ScheduleNativeCooldownTimer()
+{
+	UWorld* World = GetWorld();
+	if (!World)
+	{
+		return;
+	}
+
+	const double Now = GetServerWorldTimeSeconds();
+	double NextEndTime = TNumericLimits<double>::Max();
+	for (const FAbilityCooldownItem& Item : NativeCooldowns.GetItems())
+	{
+		if (Item.EndTime > Now)
+		{
+			NextEndTime = FMath::Min(NextEndTime, Item.EndTime);
+		}
+	}
+	for (const TPair<FGameplayTag, FAbilityCooldownItem>& Pair : PredictedNativeCooldowns)
+	{
+		if (Pair.Value.EndTime > Now)
+		{
+			NextEndTime = FMath::Min(NextEndTime, Pair.Value.EndTime);
+		}
+	}
+
+	// Expired cooldowns that are still listed are handled right away.
+	const bool bHasExpired = NativeCooldowns.GetItems().ContainsByPredicate([Now](const FAbilityCooldownItem& Item) { return Item.EndTime <= Now; }) && IsOwnerActorAuthoritative();
+	if (NextEndTime == TNumericLimits<double>::Max() && !bHasExpired)
+	{
+		World->GetTimerManager().ClearTimer(NativeCooldownTimerHandle);
+		return;
+	}
+
+	const float Delay = bHasExpired ? UE_KINDA_SMALL_NUMBER : FMath::Max(static_cast<float>(NextEndTime - Now), UE_KINDA_SMALL_NUMBER);
+	World->GetTimerManager().SetTimer(NativeCooldownTimerHandle, this, &ThisClass::HandleNativeCooldownTimer, Delay, false);
+}
+
+void UCrimAbilitySystemComponent::HandleNativeCooldownTimer()
+{
+	const double Now = GetServerWorldTimeSeconds();
+
+	if (IsOwnerActorAuthoritative())
+	{
+		NativeCooldowns.RemoveExpiredCooldowns(Now);
+	}
+
+	for (auto It = PredictedNativeCooldowns.CreateIterator(); It; ++It)
+	{
+		if (It.Value().EndTime <= Now)
+		{
+			const FGameplayTag CooldownTag = It.Key();
+			It.RemoveCurrent();
+			RefreshNativeCooldownTag(CooldownTag);
+		}
+	}
+
+	// On clients the replicated cooldowns stay listed until the server removes them, only their tags are removed.
+	for (const FAbilityCooldownItem& Item : NativeCooldowns.GetItems())
+	{
+		RefreshNativeCooldownTag(Item.CooldownTag);
+	}
+
+	ScheduleNativeCooldownTimer();
+}
+
+void UCrimAbilitySystemComponent::SetAbilityInteractionMatrix(UAbilityInteractionMatrix* NewMatrix)
+{
+	if (AbilityInteractionMatrix != NewMatrix)
+	{
+		AbilityInteractionMatrix = NewMatrix;
+
+		NumAbilitiesOutsideInteractionMatrix = 0;
+		for (const FGameplayAbilitySpec& AbilitySpec : ActivatableAbilities.Items)
+		{
+			if (AbilitySpec.Ability && (!AbilityInteractionMatrix || !AbilityInteractionMatrix->FindInteraction(AbilitySpec.Ability->GetClass())))
+			{
+				++NumAbilitiesOutsideInteractionMatrix;
+			}
+		}
+	}
+}
+
+bool UCrimAbilitySystemComponent::CanUseAbilityInteractionMatrix() const
+{
+	return AbilityInteractionMatrix && NumAbilitiesOutsideInteractionMatrix == 0 && TagRelationshipLayers.IsEmpty()
+		&& AbilityInteractionMatrix->GetTagRelationshipMapping() == TagRelationshipMapping && AbilityInteractionMatrix->IsUpToDate();
+}
+
+void UCrimAbilitySystemComponent::HandleTagRelationshipMappingChanged()
+{
+	// Resolved again on next use.
+	ActiveTagRelationshipCache = INDEX_NONE;
+	++TagRelationshipGeneration;
+
+	// The relevant tags come from the mapping, they are gathered again when the tracked abilities are re-checked.
+	for (TPair<FGameplayAbilitySpecHandle, FCrimAbilityAvailability>& Pair : AbilityAvailability)
+	{
+		MarkAbilityAvailabilityDirty(Pair.Value);
+	}
+}
+
+FCrimTagRelationshipCache& UCrimAbilitySystemComponent::GetTagRelationshipCache() const
+{
+	const uint32 MappingGeneration = UAbilityTagRelationshipMapping::GetMappingGeneration();
+	if (TagRelationshipCachesMappingGeneration != MappingGeneration)
+	{
+		// A mapping was edited, everything expanded through it is stale.
+		check(IsInGameThread());
+		TagRelationshipCaches.Reset();
+		ActiveTagRelationshipCache = INDEX_NONE;
+		TagRelationshipCachesMappingGeneration = MappingGeneration;
+		++TagRelationshipGeneration;
+	}
+
+	if (TagRelationshipCaches.IsValidIndex(ActiveTagRelationshipCache))
+	{
+		return TagRelationshipCaches[ActiveTagRelationshipCache];
+	}
+
+	check(IsInGameThread());
+
+	TArray<const UAbilityTagRelationshipMapping*, TInlineAllocator<4>> Layers;
+	Layers.Add(TagRelationshipMapping);
+	Layers.Append(TagRelationshipLayers);
+	TSharedPtr<const FAbilityTagRelationshipTable> Table = UAbilityTagRelationshipMapping::FindOrCompileLayers(Layers);
+
+	ActiveTagRelationshipCache = TagRelationshipCaches.IndexOfByPredicate([&Table](const FCrimTagRelationshipCache& Cache)
+	{
+		return Cache.Table == Table;
+	});
+
+	if (ActiveTagRelationshipCache == INDEX_NONE)
+	{
+		// Only a few stacks are in use at a time, drop the oldest one.
+		static constexpr int32 MaxTagRelationshipCaches = 8;
+		if (TagRelationshipCaches.Num() >= MaxTagRelationshipCaches)
+		{
+			TagRelationshipCaches.RemoveAt(0);
+		}
+
+		ActiveTagRelationshipCache = TagRelationshipCaches.AddDefaulted();
+		TagRelationshipCaches[ActiveTagRelationshipCache].Table = MoveTemp(Table);
+	}
+	return TagRelationshipCaches[ActiveTagRelationshipCache];
+}
+
+void UCrimAbilitySystemComponent::GetAdditionalActivationTagRequirements(const FGameplayTagContainer& AbilityTags, FGameplayTagContainer& OutActivationRequired, FGameplayTagContainer& OutActivationBlocked) const
+{
+	if (const FAbilityTagRelationshipTable* Table = GetTagRelationshipCache().Table.Get())
+	{
+		Table->GetRequiredAndBlockedActivationTags(AbilityTags, &OutActivationRequired, &OutActivationBlocked);
+	}
+}
+
+const FCrimAbilityActivationTagRequirements& UCrimAbilitySystemComponent::GetActivationTagRequirements(const UCrimGameplayAbility& Ability) const
+{
+	FCrimTagRelationshipCache& Cache = GetTagRelationshipCache();
+	const TObjectKey<UClass> AbilityClass(Ability.GetClass());
+	if (const FCrimAbilityActivationTagRequirements* Requirements = Cache.ActivationTagRequirements.Find(AbilityClass))
+	{
+		return *Requirements;
+	}
+
+	FCrimAbilityActivationTagRequirements& Requirements = Cache.ActivationTagRequirements.Add(AbilityClass);
+	Requirements.RequiredTags = Ability.ActivationRequiredTags;
+	Requirements.BlockedTags = Ability.ActivationBlockedTags;
+	GetAdditionalActivationTagRequirements(Ability.GetAssetTags(), Requirements.RequiredTags, Requirements.BlockedTags);
+
+	FCrimGameplayTagBitSetUniverse& Universe = FCrimGameplayTagBitSetUniverse::Get();
+	Requirements.bHasBits = Universe.CompileExact(Requirements.RequiredTags, Requirements.RequiredBits) && Universe.CompileExact(Requirements.BlockedTags, Requirements.BlockedBits);
+	return Requirements;
+}
+
+const FCrimGameplayTagBitSet& UCrimAbilitySystemComponent::GetOwnedGameplayTagBits() const
+{
+	const FCrimGameplayTagBitSetUniverse& Universe = FCrimGameplayTagBitSetUniverse::Get();
+	if (OwnedTagBitsGeneration != OwnedTagGeneration || OwnedTagBitsUniverseGeneration != Universe.GetGeneration())
+	{
+		check(IsInGameThread());
+		Universe.CompileWithParents(GetOwnedGameplayTags(), OwnedTagBits);
+		OwnedTagBitsUniverseGeneration = Universe.GetGeneration();
+		OwnedTagBitsGeneration = OwnedTagGeneration;
+	}
+	return OwnedTagBits;
+}
+
+const FCrimAbilityActivationTagRequirements* UCrimAbilitySystemComponent::FindActivationTagRequirements(const UCrimGameplayAbility& Ability) const
+{
+	// Doesn't switch to a changed mapping stack, so it can be used off the game thread.
+	if (!TagRelationshipCaches.IsValidIndex(ActiveTagRelationshipCache))
+	{
+		return nullptr;
+	}
+	return TagRelationshipCaches[ActiveTagRelationshipCache].ActivationTagRequirements.Find(Ability.GetClass());
+}
+
+bool UCrimAbilitySystemComponent::GetAbilityAvailability(FGameplayAbilitySpecHandle Handle)
+{
+	if (FCrimAbilityAvailability* Availability = AbilityAvailability.Find(Handle))
+	{
+		if (Availability->bDirty)
+		{
+			UpdateAbilityAvailabilityTags(Handle, *Availability);
+			Availability->bCanActivate = EvaluateAbilityAvailability(Handle);
+			Availability->bDirty = false;
+		}
+		return Availability->bCanActivate;
+	}
+
+	const FGameplayAbilitySpec* AbilitySpec = GetAbilitySpecByHandle(Handle);
+	if (!AbilitySpec || !AbilitySpec->Ability)
+	{
+		return false;
+	}
+
+	FCrimAbilityAvailability& Availability = AbilityAvailability.Add(Handle);
+	InitAbilityAvailability(*AbilitySpec, Availability);
+	Availability.bCanActivate = EvaluateAbilityAvailability(Handle);
+	Availability.bDirty = false;
+
+	// The charges may have been spent before tracking started.
+	const bool bCanActivate = Availability.bCanActivate;
+	ScheduleAbilityChargeRecheck(Handle);
+	return bCanActivate;
+}
+
+void UCrimAbilitySystemComponent::StopTrackingAbilityAvailability(FGameplayAbilitySpecHandle Handle)
+{
+	if (const FCrimAbilityAvailability* Availability = AbilityAvailability.Find(Handle))
+	{
+		RemoveAbilityAvailabilityTags(Handle, *Availability);
+		for (const FGameplayTag& AbilityTag : Availability->AbilityTags.GetGameplayTagParents())
+		{
+			if (TArray<FGameplayAbilitySpecHandle, TInlineAllocator<2>>* Handles = AvailabilityHandlesByAbilityTag.Find(AbilityTag))
+			{
+				Handles->RemoveSingleSwap(Handle);
+				if (Handles->IsEmpty())
+				{
+					AvailabilityHandlesByAbilityTag.Remove(AbilityTag);
+				}
+			}
+		}
+		for (const FGameplayAttribute& Attribute : Availability->CostAttributes)
+		{
+			if (TArray<FGameplayAbilitySpecHandle, TInlineAllocator<2>>* Handles = AvailabilityHandlesByAttribute.Find(Attribute))
+			{
+				Handles->RemoveSingleSwap(Handle);
+				if (Handles->IsEmpty())
+				{
+					AvailabilityHandlesByAttribute.Remove(Attribute);
+				}
+			}
+		}
+		AbilityAvailability.Remove(Handle);
+		ScheduleAbilityChargeRecheck(Handle);
+	}
+}
+
+void UCrimAbilitySystemComponent::InitAbilityAvailability(const FGameplayAbilitySpec& AbilitySpec, FCrimAbilityAvailability& Availability)
+{
+	Availability.CostAttributes.Reset();
+	Availability.bExclusive = false;
+
+	const UGameplayAbility* AbilityCDO = AbilitySpec.Ability;
+	check(AbilityCDO);
+
+	Availability.AbilityTags = AbilityCDO->GetAssetTags();
+	for (const FGameplayTag& AbilityTag : Availability.AbilityTags.GetGameplayTagParents())
+	{
+		AvailabilityHandlesByAbilityTag.FindOrAdd(AbilityTag).AddUnique(AbilitySpec.Handle);
+	}
+
+	TArray<FGameplayAttribute> CostAttributes;
+	GatherCostAttributes(*AbilityCDO, CostAttributes);
+	Availability.CostAttributes.Append(CostAttributes);
+
+	if (const UCrimGameplayAbility* CrimAbilityCDO = Cast<UCrimGameplayAbility>(AbilityCDO))
+	{
+		Availability.bExclusive = CrimAbilityCDO->GetActivationGroup() != EAbilityActivationGroup::Independent;
+	}
+
+	for (const FGameplayAttribute& Attribute : Availability.CostAttributes)
+	{
+		AvailabilityHandlesByAttribute.FindOrAdd(Attribute).AddUnique(AbilitySpec.Handle);
+		if (Attribute.IsValid() && !AvailabilityBoundAttributes.Contains(Attribute))
+		{
+			AvailabilityBoundAttributes.Add(Attribute);
+			GetGameplayAttributeValueChangeDelegate(Attribute).AddUObject(this, &ThisClass::HandleAvailabilityAttributeChanged);
+		}
+	}
+
+	GatherAbilityAvailabilityTags(AbilitySpec, Availability);
+}
+
+void UCrimAbilitySystemComponent::GatherAbilityAvailabilityTags(const FGameplayAbilitySpec& AbilitySpec, FCrimAbilityAvailability& Availability)
+{
+	RemoveAbilityAvailabilityTags(AbilitySpec.Handle, Availability);
+	Availability.RelevantTags.Reset();
+
+	const UGameplayAbility* AbilityCDO = AbilitySpec.Ability;
+	check(AbilityCDO);
+
+	if (const FGameplayTagContainer* CooldownTags = AbilityCDO->GetCooldownTags())
+	{
+		Availability.RelevantTags.AppendTags(*CooldownTags);
+	}
+
+	if (const UCrimGameplayAbility* CrimAbilityCDO = Cast<UCrimGameplayAbility>(AbilityCDO))
+	{
+		// Resolves the current mapping stack first, which can bump TagRelationshipGeneration.
+		const FCrimAbilityActivationTagRequirements& Requirements = GetActivationTagRequirements(*CrimAbilityCDO);
+		Availability.RelevantTags.AppendTags(Requirements.RequiredTags);
+		Availability.RelevantTags.AppendTags(Requirements.BlockedTags);
+	}
+	Availability.TagRelationshipGeneration = TagRelationshipGeneration;
+
+	for (const FGameplayTag& RelevantTag : Availability.RelevantTags)
+	{
+		AvailabilityHandlesByTag.FindOrAdd(RelevantTag).AddUnique(AbilitySpec.Handle);
+	}
+}
+
+void UCrimAbilitySystemComponent::UpdateAbilityAvailabilityTags(FGameplayAbilitySpecHandle Handle, FCrimAbilityAvailability& Availability)
+{
+	// Picks up an edited mapping before the generations are compared.
+	GetTagRelationshipCache();
+
+	if (Availability.TagRelationshipGeneration != TagRelationshipGeneration)
+	{
+		if (const FGameplayAbilitySpec* AbilitySpec = GetAbilitySpecByHandle(Handle))
+		{
+			if (AbilitySpec->Ability)
+			{
+				GatherAbilityAvailabilityTags(*AbilitySpec, Availability);
+			}
+		}
+	}
+}
+
+void UCrimAbilitySystemComponent::RemoveAbilityAvailabilityTags(FGameplayAbilitySpecHandle Handle, const FCrimAbilityAvailability& Availability)
+{
+	for (const FGameplayTag& RelevantTag : Availability.RelevantTags)
+	{
+		if (TArray<FGameplayAbilitySpecHandle, TInlineAllocator<2>>* Handles = AvailabilityHandlesByTag.Find(RelevantTag))
+		{
+			Handles->RemoveSingleSwap(Handle);
+			if (Handles->IsEmpty())
+			{
+				AvailabilityHandlesByTag.Remove(RelevantTag);
+			}
+		}
+	}
+}
+
+bool UCrimAbilitySystemComponent::EvaluateAbilityAvailability(FGameplayAbilitySpecHandle Handle)
+{
+	const FGameplayAbilitySpec* AbilitySpec = GetAbilitySpecByHandle(Handle);
+	if (!AbilitySpec || !AbilitySpec->Ability)
+	{
+		return false;
+	}
+
+	// Check against the primary instance when there is one, the same as activation does.
+	const UGameplayAbility* PrimaryInstance = AbilitySpec->GetPrimaryInstance();
+	const UGameplayAbility* Ability = PrimaryInstance ? PrimaryInstance : AbilitySpec->Ability.Get();
+	return Ability->CanActivateAbility(Handle, AbilityActorInfo.Get());
+}
+
+void UCrimAbilitySystemComponent::MarkAbilityAvailabilityDirty(FGameplayAbilitySpecHandle Handle)
+{
+	if (FCrimAbilityAvailability* Availability = AbilityAvailability.Find(Handle))
+	{
+		MarkAbilityAvailabilityDirty(*Availability);
+	}
+}
+
+void UCrimAbilitySystemComponent::MarkAbilityAvailabilityDirty(FCrimAbilityAvailability& Availability)
+{
+	Availability.bDirty = true;
+
+	if (!bAbilityAvailabilityRefreshPending)
+	{
+		if (UWorld* World = GetWorld())
+		{
+			bAbilityAvailabilityRefreshPending = true;
+			World->GetTimerManager().SetTimerForNextTick(FTimerDelegate::CreateUObject(this, &ThisClass::RefreshAbilityAvailability));
+		}
+	}
+}
+
+void UCrimAbilitySystemComponent::RefreshAbilityAvailability()
+{
+	bAbilityAvailabilityRefreshPending = false;
+
+	// Gather the changes first, listeners may start or stop tracking abilities.
+	TArray<TPair<FGameplayAbilitySpecHandle, bool>, TInlineAllocator<8>> Changes;
+	for (TPair<FGameplayAbilitySpecHandle, FCrimAbilityAvailability>& Pair : AbilityAvailability)
+	{
+		FCrimAbilityAvailability& Availability = Pair.Value;
+		if (!Availability.bDirty)
+		{
+			continue;
+		}
+
+		UpdateAbilityAvailabilityTags(Pair.Key, Availability);
+		const bool bCanActivate = EvaluateAbilityAvailability(Pair.Key);
+		Availability.bDirty = false;
+		if (bCanActivate != Availability.bCanActivate)
+		{
+			Availability.bCanActivate = bCanActivate;
+			Changes.Emplace(Pair.Key, bCanActivate);
+		}
+	}
+
+	for (const TPair<FGameplayAbilitySpecHandle, bool>& Change : Changes)
+	{
+		OnAbilityAvailabilityChangedDelegate.Broadcast(this, Change.Key, Change.Value);
+	}
+}
+
+void UCrimAbilitySystemComponent::HandleAvailabilityAttributeChanged(const FOnAttributeChangeData& Data)
+{
+	if (const TArray<FGameplayAbilitySpecHandle, TInlineAllocator<2>>* Handles = AvailabilityHandlesByAttribute.Find(Data.Attribute))
+	{
+		for (const FGameplayAbilitySpecHandle& Handle : *Handles)
+		{
+			FCrimAbilityAvailability* Availability = AbilityAvailability.Find(Handle);
+			if (Availability && !Availability->bDirty)
+			{
+				MarkAbilityAvailabilityDirty(*Availability);
+			}
+		}
+	}
+}
+
+void UCrimAbilitySystemComponent::HandleBlockedAbilityTagChanged(const FGameplayTag Tag, int32 NewCount)
+{
+	// The index holds the parents of the ability tags, so an exact lookup matches AbilityTags.HasAny(BlockedTags).
+	if (const TArray<FGameplayAbilitySpecHandle, TInlineAllocator<2>>* Handles = AvailabilityHandlesByAbilityTag.Find(Tag))
+	{
+		for (const FGameplayAbilitySpecHandle& Handle : *Handles)
+		{
+			FCrimAbilityAvailability* Availability = AbilityAvailability.Find(Handle);
+			if (Availability && !Availability->bDirty)
+			{
+				MarkAbilityAvailabilityDirty(*Availability);
+			}
+		}
+	}
+}
+
+void UCrimAbilitySystemComponent::GatherCostAttributes(const UGameplayAbility& AbilityCDO, TArray<FGameplayAttribute>& OutAttributes)
+{
+	if (const UGameplayEffect* CostGE = AbilityCDO.GetCostGameplayEffect())
+	{
+		// Attribute based magnitudes, custom calculation classes and executions read the attributes they capture, the
+		// cost changes with those as well as with the modified attribute.
+		TArray<FGameplayEffectAttributeCaptureDefinition> CaptureDefinitions;
+		for (const FGameplayModifierInfo& Modifier : CostGE->Modifiers)
+		{
+			OutAttributes.AddUnique(Modifier.Attribute);
+			Modifier.ModifierMagnitude.GetAttributeCaptureDefinitions(CaptureDefinitions);
+		}
+		for (const FGameplayEffectExecutionDefinition& Execution : CostGE->Executions)
+		{
+			Execution.GetAttributeCaptureDefinitions(CaptureDefinitions);
+		}
+
+		// The cost GE is applied to the owner, so the source and target captures both read its attributes.
+		for (const FGameplayEffectAttributeCaptureDefinition& CaptureDefinition : CaptureDefinitions)
+		{
+			OutAttributes.AddUnique(CaptureDefinition.AttributeToCapture);
+		}
+	}
+
+	if (const UCrimGameplayAbility* CrimAbilityCDO = Cast<UCrimGameplayAbility>(&AbilityCDO))
+	{
+		for (const TObjectPtr<UAbilityCost>& AdditionalCost : CrimAbilityCDO->AdditionalCosts)
+		{
+			if (AdditionalCost)
+			{
+				AdditionalCost->GetRelevantAttributes(OutAttributes);
+			}
+		}
+	}
+}
+
+void UCrimAbilitySystemComponent::BindCostEvaluationAttributes(const FGameplayAbilitySpec& AbilitySpec)
+{
+	if (!AbilitySpec.Ability)
+	{
+		return;
+	}
+
+	TArray<FGameplayAttribute> CostAttributes;
+	GatherCostAttributes(*AbilitySpec.Ability, CostAttributes);
+	for (const FGameplayAttribute& Attribute : CostAttributes)
+	{
+		if (!Attribute.IsValid())
+		{
+			continue;
+		}
+
+		CostEvaluationHandlesByAttribute.FindOrAdd(Attribute).AddUnique(AbilitySpec.Handle);
+
+		if (!CostEvaluationBoundAttributes.Contains(Attribute))
+		{
+			CostEvaluationBoundAttributes.Add(Attribute);
+			GetGameplayAttributeValueChangeDelegate(Attribute).AddUObject(this, &ThisClass::HandleCostAttributeChanged);
+		}
+	}
+}
+
+void UCrimAbilitySystemComponent::RemoveCostEvaluationAttributes(const FGameplayAbilitySpec& AbilitySpec)
+{
+	if (!AbilitySpec.Ability)
+	{
+		return;
+	}
+
+	TArray<FGameplayAttribute> CostAttributes;
+	GatherCostAttributes(*AbilitySpec.Ability, CostAttributes);
+	for (const FGameplayAttribute& Attribute : CostAttributes)
+	{
+		if (TArray<FGameplayAbilitySpecHandle>* Handles = CostEvaluationHandlesByAttribute.Find(Attribute))
+		{
+			Handles->RemoveSingleSwap(AbilitySpec.Handle);
+			if (Handles->IsEmpty())
+			{
+				CostEvaluationHandlesByAttribute.Remove(Attribute);
+			}
+		}
+	}
+}
+
+void UCrimAbilitySystemComponent::HandleCostAttributeChanged(const FOnAttributeChangeData& Data)
+{
+	// What the specs could afford this frame may no longer hold, e.g. an effect applied inside ActivateAbility drained it.
+	// Only the specs whose costs read the attribute are reset, so a regenerating resource leaves the others cached.
+	// The contexts are reset in place since a cost check may be holding one.
+	if (const TArray<FGameplayAbilitySpecHandle>* Handles = CostEvaluationHandlesByAttribute.Find(Data.Attribute))
+	{
+		for (const FGameplayAbilitySpecHandle& Handle : *Handles)
+		{
+			if (FAbilityCostEvaluationContext* Context = CostEvaluationContexts.Find(Handle))
+			{
+				Context->Reset(GFrameCounter, CostEvaluationGeneration);
+			}
+		}
+	}
+}
+
+void UCrimAbilitySystemComponent::CanActivateAbilitiesBatch(TArrayView<FCrimAbilityActivationBatch> Batches)
+{
+	check(IsInGameThread());
+
+	// Everything the parallel checks read, resolved up front so they never touch mutable state.
+	struct FPreparedAbility
+	{
+		const FGameplayAbilitySpec* AbilitySpec = nullptr;
+		const UCrimGameplayAbility* CrimAbilityCDO = nullptr;
+		const FCrimAbilityActivationTagRequirements* Requirements = nullptr;
+		const FGameplayTagContainer* CooldownTags = nullptr;
+	};
+
+	TArray<TArray<FPreparedAbility>> PreparedBatches;
+	PreparedBatches.SetNum(Batches.Num());
+
+	for (int32 BatchIndex = 0; BatchIndex < Batches.Num(); ++BatchIndex)
+	{
+		FCrimAbilityActivationBatch& Batch = Batches[BatchIndex];
+		Batch.CanActivate.Init(false, Batch.Handles.Num());
+
+		UCrimAbilitySystemComponent* CrimASC = Batch.AbilitySystemComponent;
+		if (!CrimASC)
+		{
+			continue;
+		}
+
+		TArray<FPreparedAbility>& PreparedAbilities = PreparedBatches[BatchIndex];
+		PreparedAbilities.SetNum(Batch.Handles.Num());
+		for (int32 Index = 0; Index < Batch.Handles.Num(); ++Index)
+		{
+			FPreparedAbility& Prepared = PreparedAbilities[Index];
+			Prepared.AbilitySpec = CrimASC->GetAbilitySpecByHandle(Batch.Handles[Index]);
+			Prepared.CrimAbilityCDO = Prepared.AbilitySpec ? Cast<UCrimGameplayAbility>(Prepared.AbilitySpec->Ability) : nullptr;
+			if (Prepared.CrimAbilityCDO)
+			{
+				// Fill the cache now, the pointers are taken once nothing else will be added to it.
+				CrimASC->GetActivationTagRequirements(*Prepared.CrimAbilityCDO);
+				Prepared.CooldownTags = Prepared.CrimAbilityCDO->GetCooldownTags();
+			}
+		}
+	}
+
+	// The same component can appear in several batches, so only take the pointers once every batch filled its cache.
+	for (int32 BatchIndex = 0; BatchIndex < Batches.Num(); ++BatchIndex)
+	{
+		const UCrimAbilitySystemComponent* CrimASC = Batches[BatchIndex].AbilitySystemComponent;
+		if (!CrimASC)
+		{
+			continue;
+		}
+
+		for (FPreparedAbility& Prepared : PreparedBatches[BatchIndex])
+		{
+			if (Prepared.CrimAbilityCDO)
+			{
+				Prepared.Requirements = CrimASC->FindActivationTagRequirements(*Prepared.CrimAbilityCDO);
+			}
+		}
+	}
+
+	// Rebuild the owned tag bits after every requirement has registered its tags.
+	TArray<const FCrimGameplayTagBitSet*> OwnedTagBits;
+	OwnedTagBits.SetNumZeroed(Batches.Num());
+	for (int32 BatchIndex = 0; BatchIndex < Batches.Num(); ++BatchIndex)
+	{
+		if (const UCrimAbilitySystemComponent* CrimASC = Batches[BatchIndex].AbilitySystemComponent)
+		{
+			OwnedTagBits[BatchIndex] = &CrimASC->GetOwnedGameplayTagBits();
+		}
+	}
+
+	ParallelFor(Batches.Num(), [&Batches, &PreparedBatches, &OwnedTagBits](int32 BatchIndex)
+	{
+		FCrimAbilityActivationBatch& Batch = Batches[BatchIndex];
+		const UCrimAbilitySystemComponent* CrimASC = Batch.AbilitySystemComponent;
+		if (!CrimASC)
+		{
+			return;
+		}
+
+		const FGameplayTagContainer& OwnedTags = CrimASC->GetOwnedTagSnapshot();
+		const TArray<FPreparedAbility>& PreparedAbilities = PreparedBatches[BatchIndex];
+		for (int32 Index = 0; Index < PreparedAbilities.Num(); ++Index)
+		{
+			const FPreparedAbility& Prepared = PreparedAbilities[Index];
+			const UCrimGameplayAbility* CrimAbilityCDO = Prepared.CrimAbilityCDO;
+			if (!CrimAbilityCDO || !Prepared.Requirements)
+			{
+				continue;
+			}
+
+			// Only instanced per execution abilities (or ones that retrigger) can activate while already active.
+			if (Prepared.AbilitySpec->IsActive() && CrimAbilityCDO->GetInstancingPolicy() != EGameplayAbilityInstancingPolicy::InstancedPerExecution && !CrimAbilityCDO->bRetriggerInstancedAbility)
+			{
+				continue;
+			}
+
+			if (Prepared.CooldownTags && OwnedTags.HasAny(*Prepared.CooldownTags))
+			{
+				continue;
+			}
+
+			if (CrimASC->AreAbilityTagsBlocked(CrimAbilityCDO->GetAssetTags()))
+			{
+				continue;
+			}
+
+			const FCrimAbilityActivationTagRequirements& Requirements = *Prepared.Requirements;
+			if (Requirements.bHasBits)
+			{
+				const FCrimGameplayTagBitSet& OwnedBits = *OwnedTagBits[BatchIndex];
+				if (OwnedBits.HasAny(Requirements.BlockedBits) || !OwnedBits.HasAll(Requirements.RequiredBits))
+				{
+					continue;
+				}
+			}
+			else if (OwnedTags.HasAny(Requirements.BlockedTags) || !OwnedTags.HasAll(Requirements.RequiredTags))
+			{
+				continue;
+			}
+
+			if (CrimASC->IsActivationGroupBlocked(CrimAbilityCDO->GetActivationGroup()))
+			{
+				continue;
+			}
+
+			Batch.CanActivate[Index] = true;
+		}
+	});
+}
+
+FGameplayAbilitySpec* UCrimAbilitySystemComponent::GetAbilitySpecByHandle(FGameplayAbilitySpecHandle Handle)
+{
+	if (!Handle.IsValid())
+	{
+		return nullptr;
+	}
+
+	if (bSpecHandleIndexDirty)
+	{
+		RebuildSpecHandleIndex();
+	}
+
+	const int32* Index = SpecHandleToIndex.Find(Handle);
+	if (Index && !(ActivatableAbilities.Items.IsValidIndex(*Index) && ActivatableAbilities.Items[*Index].Handle == Handle))
+	{
+		// The items were reordered without a notification, rebuild and try again.
+		RebuildSpecHandleIndex();
+		Index = SpecHandleToIndex.Find(Handle);
+	}
+
+	return Index ? &ActivatableAbilities.Items[*Index] : nullptr;
+}
+
+FGameplayAbilitySpec* UCrimAbilitySystemComponent::GetAbilitySpecWithAbilityTag(const FGameplayTag& AbilityTag)
+{
+	if (AbilityTag.IsValid())
+	{
+		if (const TArray<FGameplayAbilitySpecHandle>* Handles = AbilityTagToSpecHandles.Find(AbilityTag))
+		{
+			for (const FGameplayAbilitySpecHandle& Handle : *Handles)
+			{
+				if (FGameplayAbilitySpec* AbilitySpec = GetAbilitySpecByHandle(Handle))
+				{
+					return AbilitySpec;
+				}
+			}
+		}
+	}
+	return nullptr;
+}
+
+void UCrimAbilitySystemComponent::GetAllAbilitySpecsWithAbilityTag(const FGameplayTag& AbilityTag, TArray<FGameplayAbilitySpec*>& OutAbilitySpecs)
+{
+	OutAbilitySpecs.Reset();
+	if (AbilityTag.IsValid())
+	{
+		if (const TArray<FGameplayAbilitySpecHandle>* Handles = AbilityTagToSpecHandles.Find(AbilityTag))
+		{
+			OutAbilitySpecs.Reserve(Handles->Num());
+			for (const FGameplayAbilitySpecHandle& Handle : *Handles)
+			{
+				if (FGameplayAbilitySpec* AbilitySpec = GetAbilitySpecByHandle(Handle))
+				{
+					OutAbilitySpecs.Add(AbilitySpec);
+				}
+			}
+		}
+	}
+}
+
+FGameplayAbilitySpec* UCrimAbilitySystemComponent::GetAbilitySpecWithDynamicTag(const FGameplayTag& DynamicTag)
+{
+	if (DynamicTag.IsValid())
+	{
+		if (const TArray<FGameplayAbilitySpecHandle>* Handles = DynamicTagToSpecHandles.Find(DynamicTag))
+		{
+			for (const FGameplayAbilitySpecHandle& Handle : *Handles)
+			{
+				if (FGameplayAbilitySpec* AbilitySpec = GetAbilitySpecByHandle(Handle))
+				{
+					return AbilitySpec;
+				}
+			}
+		}
+	}
+	return nullptr;
+}
+
+void UCrimAbilitySystemComponent::GetAllAbilitySpecsWithDynamicTag(const FGameplayTag& DynamicTag, TArray<FGameplayAbilitySpec*>& OutAbilitySpecs)
+{
+	OutAbilitySpecs.Reset();
+	if (DynamicTag.IsValid())
+	{
+		if (const TArray<FGameplayAbilitySpecHandle>* Handles = DynamicTagToSpecHandles.Find(DynamicTag))
+		{
+			OutAbilitySpecs.Reserve(Handles->Num());
+			for (const FGameplayAbilitySpecHandle& Handle : *Handles)
+			{
+				if (FGameplayAbilitySpec* AbilitySpec = GetAbilitySpecByHandle(Handle))
+				{
+					OutAbilitySpecs.Add(AbilitySpec);
+				}
+			}
+		}
+	}
+}
+
+FGameplayAbilitySpec* UCrimAbilitySystemComponent::GetAbilitySpecByClass(TSubclassOf<UGameplayAbility> AbilityClass)
+{
+	if (AbilityClass)
+	{
+		for (auto It = AbilityClassToSpecHandles.CreateConstKeyIterator(AbilityClass.Get()); It; ++It)
+		{
+			if (FGameplayAbilitySpec* AbilitySpec = GetAbilitySpecByHandle(It.Value()))
+			{
+				return AbilitySpec;
+			}
+		}
+	}
+	return nullptr;
+}
+
+void UCrimAbilitySystemComponent::GetAllAbilitySpecsByClass(TSubclassOf<UGameplayAbility> AbilityClass, TArray<FGameplayAbilitySpec*>& OutAbilitySpecs)
+{
+	OutAbilitySpecs.Reset();
+	if (AbilityClass)
+	{
+		for (auto It = AbilityClassToSpecHandles.CreateConstKeyIterator(AbilityClass.Get()); It; ++It)
+		{
+			if (FGameplayAbilitySpec* AbilitySpec = GetAbilitySpecByHandle(It.Value()))
+			{
+				OutAbilitySpecs.Add(AbilitySpec);
+			}
+		}
+	}
+}
+
+void UCrimAbilitySystemComponent::ForEachAbilitySpec(const FCrimAbilitySpecQuery& Query, TFunctionRef<bool(FGameplayAbilitySpec& AbilitySpec)> Func)
+{
+	ABILITYLIST_SCOPE_LOCK();
+
+	// Pick the smallest candidate list the query can use.
+	const TArray<FGameplayAbilitySpecHandle>* CandidateHandles = nullptr;
+	auto ConsiderCandidates = [&CandidateHandles](const TArray<FGameplayAbilitySpecHandle>* Handles)
+	{
+		if (!CandidateHandles || !Handles || Handles->Num() < CandidateHandles->Num())
+		{
+			CandidateHandles = Handles;
+		}
+	};
+
+	bool bHasEmptyIndex = false;
+	for (const FGameplayTag& Tag : Query.AssetTags)
+	{
+		const TArray<FGameplayAbilitySpecHandle>* Handles = AbilityTagToSpecHandles.Find(Tag);
+		bHasEmptyIndex |= !Handles;
+		ConsiderCandidates(Handles);
+	}
+	for (const FGameplayTag& Tag : Query.DynamicTags)
+	{
+		const TArray<FGameplayAbilitySpecHandle>* Handles = DynamicTagToSpecHandles.Find(Tag);
+		bHasEmptyIndex |= !Handles;
+		ConsiderCandidates(Handles);
+	}
+
+	if (bHasEmptyIndex)
+	{
+		// A required tag is not on any spec.
+		return;
+	}
+
+	const int32 ClassCandidateNum = Query.AbilityClass ? AbilityClassToSpecHandles.Num(Query.AbilityClass) : MAX_int32;
+	const TArray<FCrimActiveAbility>* ActiveCandidates = nullptr;
+	if (Query.ActiveState.Get(false) && Query.ActivationGroup.IsSet())
+	{
+		ActiveCandidates = &ActiveAbilitiesByGroup[(uint8)Query.ActivationGroup.GetValue()];
+	}
+
+	const int32 HandleCandidateNum = CandidateHandles ? CandidateHandles->Num() : MAX_int32;
+	const int32 ActiveCandidateNum = ActiveCandidates ? ActiveCandidates->Num() : MAX_int32;
+
+	auto VisitHandle = [this, &Query, &Func](FGameplayAbilitySpecHandle Handle)
+	{
+		FGameplayAbilitySpec* AbilitySpec = GetAbilitySpecByHandle(Handle);
+		return !AbilitySpec || !Query.Matches(*this, *AbilitySpec) || Func(*AbilitySpec);
+	};
+
+	if (ActiveCandidates && ActiveCandidateNum <= HandleCandidateNum && ActiveCandidateNum <= ClassCandidateNum)
+	{
+		// Instanced per execution abilities can be running more than once from the same spec.
+		TArray<FGameplayAbilitySpecHandle, TInlineAllocator<8>> VisitedHandles;
+		for (int32 Index = 0; Index < ActiveCandidates->Num(); ++Index)
+		{
+			const FGameplayAbilitySpecHandle Handle = (*ActiveCandidates)[Index].Handle;
+			if (VisitedHandles.Contains(Handle))
+			{
+				continue;
+			}
+			VisitedHandles.Add(Handle);
+
+			if (!VisitHandle(Handle))
+			{
+				return;
+			}
+		}
+	}
+	else if (Query.AbilityClass && ClassCandidateNum <= HandleCandidateNum)
+	{
+		for (auto It = AbilityClassToSpecHandles.CreateConstKeyIterator(Query.AbilityClass); It; ++It)
+		{
+			if (!VisitHandle(It.Value()))
+			{
+				return;
+			}
+		}
+	}
+	else if (CandidateHandles)
+	{
+		for (const FGameplayAbilitySpecHandle& Handle : *CandidateHandles)
+		{
+			if (!VisitHandle(Handle))
+			{
+				return;
+			}
+		}
+	}
+	else
+	{
+		for (FGameplayAbilitySpec& AbilitySpec : ActivatableAbilities.Items)
+		{
+			if (Query.Matches(*this, AbilitySpec) && !Func(AbilitySpec))
+			{
+				return;
+			}
+		}
+	}
+}
+
+FGameplayAbilitySpec* UCrimAbilitySystemComponent::FindAbilitySpec(const FCrimAbilitySpecQuery& Query)
+{
+	FGameplayAbilitySpec* FoundSpec = nullptr;
+	ForEachAbilitySpec(Query, [&FoundSpec](FGameplayAbilitySpec& AbilitySpec)
+	{
+		FoundSpec = &AbilitySpec;
+		return false;
+	});
+	return FoundSpec;
+}
+
+void UCrimAbilitySystemComponent::AddDynamicTagToAbilitySpec(FGameplayAbilitySpec* AbilitySpec, const FGameplayTag& DynamicTag)
+{
+	if (!GetOwner()->HasAuthority())
+	{
+		return;
+	}
+	
+	if (!AbilitySpec)
+	{
+		return;
+	}
+
+	if (AbilitySpec->GetDynamicSpecSourceTags().HasTag(DynamicTag))
+	{
+		// Dynamic Spec Source tags already has the DynamicTag.
+		return;
+	}
+
+	// Strip the tag from its previous owner. Copy the handles since the index is modified while removing.
+	if (const TArray<FGameplayAbilitySpecHandle>* Handles = DynamicTagToSpecHandles.Find(DynamicTag))
+	{
+		const TArray<FGameplayAbilitySpecHandle, TInlineAllocator<4>> PreviousOwners(*Handles);
+		for (const FGameplayAbilitySpecHandle& Handle : PreviousOwners)
+		{
+			FGameplayAbilitySpec* Spec = GetAbilitySpecByHandle(Handle);
+			if (Spec && Spec->GetDynamicSpecSourceTags().HasTagExact(DynamicTag))
+			{
+				RemoveAbilitySpecFromDynamicTagIndex(*Spec);
+				Spec->GetDynamicSpecSourceTags().RemoveTag(DynamicTag);
+				AddAbilitySpecToDynamicTagIndex(*Spec);
+				MarkAbilitySpecDirty(*Spec);
+			}
+		}
+	}
+
+	RemoveAbilitySpecFromDynamicTagIndex(*AbilitySpec);
+	AbilitySpec->GetDynamicSpecSourceTags().AddTag(DynamicTag);
+	AddAbilitySpecToDynamicTagIndex(*AbilitySpec);
+	MarkAbilitySpecDirty(*AbilitySpec);
+}
+
+void UCrimAbilitySystemComponent::RemoveDynamicTagFromAbilitySpec(FGameplayAbilitySpec* AbilitySpec, const FGameplayTag& DynamicTag)
+{
+	if (!GetOwner()->HasAuthority())
+	{
+		return;
+	}
+	
+	if (!AbilitySpec)
+	{
+		return;
+	}
+
+	if (!AbilitySpec->GetDynamicSpecSourceTags().HasTag(DynamicTag))
+	{
+		// Dynamic Spec Source tags already does not have the tag.
+		return;
+	}
+
+	RemoveAbilitySpecFromDynamicTagIndex(*AbilitySpec);
+	AbilitySpec->GetDynamicSpecSourceTags().RemoveTag(DynamicTag);
+	AddAbilitySpecToDynamicTagIndex(*AbilitySpec);
+	MarkAbilitySpecDirty(*AbilitySpec);
+}
+
+void UCrimAbilitySystemComponent::TryActivateAbilitiesOnSpawn()
+{
+	if (OnSpawnAbilitySpecHandles.IsEmpty())
+	{
+		return;
+	}
+
+	ABILITYLIST_SCOPE_LOCK();
+
+	// Activation can end up granting or removing abilities, those are deferred by the scope lock but iterate a copy to be safe.
+	const TArray<FGameplayAbilitySpecHandle, TInlineAllocator<8>> Handles(OnSpawnAbilitySpecHandles);
+	for (const FGameplayAbilitySpecHandle& Handle : Handles)
+	{
+		if (const FGameplayAbilitySpec* AbilitySpec = GetAbilitySpecByHandle(Handle))
+		{
+			CastChecked<UCrimGameplayAbility>(AbilitySpec->Ability)->TryActivateAbilityOnSpawn(AbilityActorInfo.Get(), *AbilitySpec);
+		}
+	}
+}
+
+void UCrimAbilitySystemComponent::AbilitySpecInputPressed(FGameplayAbilitySpec& Spec)
+{
+	Super::AbilitySpecInputPressed(Spec);
+
+	// We don't support UGameplayAbility::bReplicateInputDirectly.
+	// Use replicated events instead so that the WaitInputPress ability task works.
+	if (Spec.IsActive())
+	{
+		// Invoke the InputPressed event. This is not replicated here. If someone is listening, they may replicate the InputPressed event to the server.
+		InvokeReplicatedEvent(EAbilityGenericReplicatedEvent::InputPressed,
+			Spec.Handle,
+			Spec.GetPrimaryInstance()->GetCurrentActivationInfo().GetActivationPredictionKey()
+		);
+	}
+}
+
+void UCrimAbilitySystemComponent::AbilitySpecInputReleased(FGameplayAbilitySpec& Spec)
+{
+	Super::AbilitySpecInputReleased(Spec);
+
+	// We don't support UGameplayAbility::bReplicateInputDirectly.
+	// Use replicated events instead so that the WaitInputRelease ability task works.
+	if (Spec.IsActive())
+	{
+		// Invoke the InputReleased event. This is not replicated here. If someone is listening, they may replicate the InputReleased event to the server.
+		InvokeReplicatedEvent(EAbilityGenericReplicatedEvent::InputReleased,
+			Spec.Handle,
+			Spec.GetPrimaryInstance()->GetCurrentActivationInfo().GetActivationPredictionKey()
+		);
+	}
+}
+
+void UCrimAbilitySystemComponent::NotifyAbilityActivated(const FGameplayAbilitySpecHandle Handle, UGameplayAbility* Ability)
+{
+	Super::NotifyAbilityActivated(Handle, Ability);
+
+	MarkAbilityAvailabilityDirty(Handle);
+
+	if (Ability)
+	{
+		// Walk the parents directly to avoid building a parent tag container on every activation.
+		for (const FGameplayTag& AssetTag : Ability->GetAssetTags())
+		{
+			for (FGameplayTag Tag = AssetTag; Tag.IsValid(); Tag = Tag.RequestDirectParent())
+			{
+				ActiveAbilitiesByTag.FindOrAdd(Tag).AddUnique({Ability, Handle});
+			}
+		}
+	}
+	
+	if (UCrimGameplayAbility* CrimAbility = Cast<UCrimGameplayAbility>(Ability))
+	{
+		AddAbilityToActivationGroup(CrimAbility->GetActivationGroup(), CrimAbility, Handle);
+	}
+	else if (Ability)
+	{
+		ActiveNonCrimAbilities.Add({Ability, Handle});
+	}
+}
+
+void UCrimAbilitySystemComponent::NotifyAbilityFailed(const FGameplayAbilitySpecHandle Handle, UGameplayAbility* Ability, const FGameplayTagContainer& FailureReason)
+{
+	if (APawn* Avatar = Cast<APawn>(GetAvatarActor()))
+	{
+		if (!Avatar->IsLocallyControlled() && Ability->IsSupportedForNetworking())
+		{
+			QueueAbilityFailedNotify(Ability, FailureReason);
+			return;
+		}
+	}
+
+	HandleAbilityFailed(Ability, FailureReason);
+}
+
+void UCrimAbilitySystemComponent::NotifyAbilityEnded(FGameplayAbilitySpecHandle Handle, UGameplayAbility* Ability, bool bWasCancelled)
+{
+	Super::NotifyAbilityEnded(Handle, Ability, bWasCancelled);
+
+	MarkAbilityAvailabilityDirty(Handle);
+
+	if (Ability)
+	{
+		for (const FGameplayTag& AssetTag : Ability->GetAssetTags())
+		{
+			for (FGameplayTag Tag = AssetTag; Tag.IsValid(); Tag = Tag.RequestDirectParent())
+			{
+				if (TArray<FCrimActiveAbility>* ActiveAbilities = ActiveAbilitiesByTag.Find(Tag))
+				{
+					ActiveAbilities->RemoveSingleSwap({Ability, Handle});
+					if (ActiveAbilities->IsEmpty())
+					{
+						ActiveAbilitiesByTag.Remove(Tag);
+					}
+				}
+			}
+		}
 	}
-}
+
+	if (UCrimGameplayAbility* CrimAbility = Cast<UCrimGameplayAbility>(Ability))
+	{
+		RemoveAbilityFromActivationGroup(CrimAbility->GetActivationGroup(), CrimAbility, Handle);
+	}
+	else if (Ability)
+	{
+		ActiveNonCrimAbilities.RemoveSingleSwap({Ability, Handle});
+	}
+}
 
 void UCrimAbilitySystemComponent::ApplyAbilityBlockAndCancelTags(const FGameplayTagContainer& AbilityTags,
 	UGameplayAbility* RequestingAbility, bool bEnableBlockTags, const FGameplayTagContainer& BlockTags,
 	bool bExecuteCancelTags, const FGameplayTagContainer& CancelTags)
 {
-	FGameplayTagContainer ModifiedBlockTags = BlockTags;
-	FGameplayTagContainer ModifiedCancelTags = CancelTags;
+	const FGameplayTagContainer* ExpandedBlockTags = &BlockTags;
+	const FGameplayTagContainer* ExpandedCancelTags = &CancelTags;
+
+	// Temporary containers for calls that don't pass the ability's own tags, those can't be cached.
+	FGameplayTagContainer ModifiedBlockTags;
+	FGameplayTagContainer ModifiedCancelTags;
+
+	const UCrimGameplayAbility* CrimAbility = Cast<UCrimGameplayAbility>(RequestingAbility);
+	const bool bUsesOwnTags = CrimAbility && &AbilityTags == &CrimAbility->GetAssetTags() && &BlockTags == &CrimAbility->BlockAbilitiesWithTag && &CancelTags == &CrimAbility->CancelAbilitiesWithTag;
+
+	// The matrix already resolved which abilities the cancel tags match, their running specs are canceled directly.
+	const FAbilityInteraction* Interaction = nullptr;
+	if (bExecuteCancelTags && bUsesOwnTags && CanUseAbilityInteractionMatrix())
+	{
+		// Null if the ability's asset or cancel tags changed since the matrix was built, the tags are matched then.
+		Interaction = AbilityInteractionMatrix->FindInteraction(*CrimAbility);
+	}
+
+	if (const FAbilityTagRelationshipTable* Table = GetTagRelationshipCache().Table.Get())
+	{
+		if (bUsesOwnTags)
+		{
+			const FCrimAbilityBlockAndCancelTags& Expanded = GetBlockAndCancelTags(*CrimAbility);
+			if (Expanded.bMappingAddsTags)
+			{
+				ExpandedBlockTags = &Expanded.BlockTags;
+				ExpandedCancelTags = &Expanded.CancelTags;
+			}
+		}
+		else
+		{
+			// Use the mapping to expand the ability tags into block and cancel tag
+			ModifiedBlockTags = BlockTags;
+			ModifiedCancelTags = CancelTags;
+			Table->GetAbilityTagsToBlockAndCancel(AbilityTags, &ModifiedBlockTags, &ModifiedCancelTags);
+			ExpandedBlockTags = &ModifiedBlockTags;
+			ExpandedCancelTags = &ModifiedCancelTags;
+		}
+	}
+
+	Super::ApplyAbilityBlockAndCancelTags(AbilityTags, RequestingAbility, bEnableBlockTags, *ExpandedBlockTags, bExecuteCancelTags && !Interaction, *ExpandedCancelTags);
+
+	// Cancel after the block tags are added, the same order as Super, so the canceled abilities can't re-activate a blocked one.
+	if (Interaction)
+	{
+		TArray<FGameplayAbilitySpecHandle, TInlineAllocator<8>> HandlesToCancel;
+		for (const TSubclassOf<UGameplayAbility>& CanceledAbility : Interaction->CanceledAbilities)
+		{
+			AbilityClassToSpecHandles.MultiFind(CanceledAbility.Get(), HandlesToCancel);
+		}
+
+		ABILITYLIST_SCOPE_LOCK();
+		for (const FGameplayAbilitySpecHandle& Handle : HandlesToCancel)
+		{
+			FGameplayAbilitySpec* AbilitySpec = GetAbilitySpecByHandle(Handle);
+			if (AbilitySpec && AbilitySpec->Ability && AbilitySpec->IsActive())
+			{
+				CancelAbilitySpec(*AbilitySpec, RequestingAbility);
+			}
+		}
+	}
+
+}
+
+const FCrimAbilityBlockAndCancelTags& UCrimAbilitySystemComponent::GetBlockAndCancelTags(const UCrimGameplayAbility& Ability)
+{
+	FCrimTagRelationshipCache& Cache = GetTagRelationshipCache();
+	const TObjectKey<UClass> AbilityClass(Ability.GetClass());
+	if (const FCrimAbilityBlockAndCancelTags* Expanded = Cache.BlockAndCancelTags.Find(AbilityClass))
+	{
+		return *Expanded;
+	}
 
-	if (TagRelationshipMapping)
+	FCrimAbilityBlockAndCancelTags& Expanded = Cache.BlockAndCancelTags.Add(AbilityClass);
+	Expanded.BlockTags = Ability.BlockAbilitiesWithTag;
+	Expanded.CancelTags = Ability.CancelAbilitiesWithTag;
+	if (const FAbilityTagRelationshipTable* Table = Cache.Table.Get())
 	{
-		// Use the mapping to expand the ability tags into block and cancel tag
-		TagRelationshipMapping->GetAbilityTagsToBlockAndCancel(AbilityTags, &ModifiedBlockTags, &ModifiedCancelTags);
+		Table->GetAbilityTagsToBlockAndCancel(Ability.GetAssetTags(), &Expanded.BlockTags, &Expanded.CancelTags);
 	}
 
-	Super::ApplyAbilityBlockAndCancelTags(AbilityTags, RequestingAbility, bEnableBlockTags, ModifiedBlockTags, bExecuteCancelTags, ModifiedCancelTags);
+	// Only keep the copies when the mapping added something, otherwise the ability's own containers are used.
+	Expanded.bMappingAddsTags = Expanded.BlockTags.Num() != Ability.BlockAbilitiesWithTag.Num() || Expanded.CancelTags.Num() != Ability.CancelAbilitiesWithTag.Num();
+	if (!Expanded.bMappingAddsTags)
+	{
+		Expanded.BlockTags.Reset();
+		Expanded.CancelTags.Reset();
+	}
+	return Expanded;
 }
 
 void UCrimAbilitySystemComponent::HandleChangeAbilityCanBeCanceled(const FGameplayTagContainer& AbilityTags, UGameplayAbility* RequestingAbility, bool bCanBeCanceled)
@@ -456,19 +2078,307 @@ void UCrimAbilitySystemComponent::HandleChangeAbilityCanBeCanceled(const FGamepl
 
 void UCrimAbilitySystemComponent::OnGiveAbility(FGameplayAbilitySpec& AbilitySpec)
 {
+	// GiveAbility appends the new spec, so the index can be updated in place.
+	const int32 LastIndex = ActivatableAbilities.Items.Num() - 1;
+	if (!bSpecHandleIndexDirty && ActivatableAbilities.Items.IsValidIndex(LastIndex) && ActivatableAbilities.Items[LastIndex].Handle == AbilitySpec.Handle)
+	{
+		SpecHandleToIndex.Add(AbilitySpec.Handle, LastIndex);
+	}
+	else
+	{
+		bSpecHandleIndexDirty = true;
+	}
+
+	AddAbilitySpecToIndexes(AbilitySpec);
+	BindCostEvaluationAttributes(AbilitySpec);
+
 	Super::OnGiveAbility(AbilitySpec);
-	OnAbilityGivenDelegate.Broadcast(this, AbilitySpec);
+
+	if (bIsProcessingAbilityBatch)
+	{
+		// Broadcast once the whole batch is given.
+		BatchGivenAbilitySpecHandles.Add(AbilitySpec.Handle);
+	}
+	else
+	{
+		OnAbilityGivenDelegate.Broadcast(this, AbilitySpec);
+	}
 }
 
 void UCrimAbilitySystemComponent::OnRemoveAbility(FGameplayAbilitySpec& AbilitySpec)
 {
+	// ClearAbility and ClearAbilities remove the spec after this notification and swap the last spec into its slot, so
+	// only those two entries change. Clients remove replicated specs in the serializer's order and rebuild in OnRep_ActivateAbilities.
+	const int32 RemovedIndex = static_cast<int32>(&AbilitySpec - ActivatableAbilities.Items.GetData());
+	if (!bSpecHandleIndexDirty && IsOwnerActorAuthoritative() && ActivatableAbilities.Items.IsValidIndex(RemovedIndex))
+	{
+		SpecHandleToIndex.Remove(AbilitySpec.Handle);
+
+		const int32 LastIndex = ActivatableAbilities.Items.Num() - 1;
+		if (RemovedIndex != LastIndex)
+		{
+			SpecHandleToIndex.Add(ActivatableAbilities.Items[LastIndex].Handle, RemovedIndex);
+		}
+	}
+	else
+	{
+		bSpecHandleIndexDirty = true;
+	}
+
+	RemoveAbilitySpecFromIndexes(AbilitySpec);
+	StopTrackingAbilityAvailability(AbilitySpec.Handle);
+
+	PredictedAbilityCharges.Remove(AbilitySpec.Handle);
+	CostEvaluationContexts.Remove(AbilitySpec.Handle);
+	RemoveCostEvaluationAttributes(AbilitySpec);
+	if (IsOwnerActorAuthoritative())
+	{
+		AbilityCharges.Remove(AbilitySpec.Handle);
+	}
+
 	Super::OnRemoveAbility(AbilitySpec);
-	OnAbilityRemovedDelegate.Broadcast(this, AbilitySpec);
+
+	if (bIsProcessingAbilityBatch)
+	{
+		// The spec is gone once the batch ends, keep a copy to broadcast.
+		BatchRemovedAbilitySpecs.Add(AbilitySpec);
+	}
+	else
+	{
+		OnAbilityRemovedDelegate.Broadcast(this, AbilitySpec);
+	}
 }
 
-void UCrimAbilitySystemComponent::ClientNotifyAbilityFailed_Implementation(const UGameplayAbility* Ability, const FGameplayTagContainer& FailureReason)
+void UCrimAbilitySystemComponent::OnTagUpdated(const FGameplayTag& Tag, bool TagExists)
 {
-	HandleAbilityFailed(Ability, FailureReason);
+	Super::OnTagUpdated(Tag, TagExists);
+
+	// Zero is never a valid generation so consumers can use it as "not computed".
+	if (++OwnedTagGeneration == 0)
+	{
+		++OwnedTagGeneration;
+	}
+
+	if (AvailabilityHandlesByTag.IsEmpty())
+	{
+		return;
+	}
+
+	// A relevant tag matches the updated tag or any of its parents.
+	for (FGameplayTag MatchTag = Tag; MatchTag.IsValid(); MatchTag = MatchTag.RequestDirectParent())
+	{
+		if (const TArray<FGameplayAbilitySpecHandle, TInlineAllocator<2>>* Handles = AvailabilityHandlesByTag.Find(MatchTag))
+		{
+			for (const FGameplayAbilitySpecHandle& Handle : *Handles)
+			{
+				FCrimAbilityAvailability* Availability = AbilityAvailability.Find(Handle);
+				if (Availability && !Availability->bDirty)
+				{
+					MarkAbilityAvailabilityDirty(*Availability);
+				}
+			}
+		}
+	}
+}
+
+void UCrimAbilitySystemComponent::OnRep_ActivateAbilities()
+{
+	Super::OnRep_ActivateAbilities();
+
+	bSpecHandleIndexDirty = true;
+
+	// Dynamic tags can change on existing specs without a give or remove notification.
+	RebuildDynamicTagIndex();
+}
+
+void UCrimAbilitySystemComponent::AddAbilitySpecToIndexes(const FGameplayAbilitySpec& AbilitySpec)
+{
+	if (!AbilitySpec.Ability)
+	{
+		return;
+	}
+
+	// Index the parent tags as well so lookups keep the HasTag semantics.
+	for (const FGameplayTag& AbilityTag : AbilitySpec.Ability->GetAssetTags().GetGameplayTagParents())
+	{
+		AbilityTagToSpecHandles.FindOrAdd(AbilityTag).AddUnique(AbilitySpec.Handle);
+	}
+
+	AbilityClassToSpecHandles.AddUnique(AbilitySpec.Ability->GetClass(), AbilitySpec.Handle);
+
+	if (!AbilityInteractionMatrix || !AbilityInteractionMatrix->FindInteraction(AbilitySpec.Ability->GetClass()))
+	{
+		++NumAbilitiesOutsideInteractionMatrix;
+	}
+
+	const UCrimGameplayAbility* CrimAbilityCDO = Cast<UCrimGameplayAbility>(AbilitySpec.Ability);
+	if (CrimAbilityCDO && CrimAbilityCDO->GetActivationPolicy() == EAbilityActivationPolicy::OnSpawn)
+	{
+		OnSpawnAbilitySpecHandles.AddUnique(AbilitySpec.Handle);
+	}
+
+	AddAbilitySpecToDynamicTagIndex(AbilitySpec);
+}
+
+void UCrimAbilitySystemComponent::RemoveAbilitySpecFromIndexes(const FGameplayAbilitySpec& AbilitySpec)
+{
+	if (!AbilitySpec.Ability)
+	{
+		return;
+	}
+
+	for (const FGameplayTag& AbilityTag : AbilitySpec.Ability->GetAssetTags().GetGameplayTagParents())
+	{
+		if (TArray<FGameplayAbilitySpecHandle>* Handles = AbilityTagToSpecHandles.Find(AbilityTag))
+		{
+			Handles->Remove(AbilitySpec.Handle);
+			if (Handles->IsEmpty())
+			{
+				AbilityTagToSpecHandles.Remove(AbilityTag);
+			}
+		}
+	}
+
+	AbilityClassToSpecHandles.RemoveSingle(AbilitySpec.Ability->GetClass(), AbilitySpec.Handle);
+
+	if (!AbilityInteractionMatrix || !AbilityInteractionMatrix->FindInteraction(AbilitySpec.Ability->GetClass()))
+	{
+		--NumAbilitiesOutsideInteractionMatrix;
+	}
+
+	OnSpawnAbilitySpecHandles.Remove(AbilitySpec.Handle);
+
+	RemoveAbilitySpecFromDynamicTagIndex(AbilitySpec);
+}
+
+void UCrimAbilitySystemComponent::RebuildSpecHandleIndex()
+{
+	SpecHandleToIndex.Reset();
+	for (int32 Index = 0; Index < ActivatableAbilities.Items.Num(); ++Index)
+	{
+		SpecHandleToIndex.Add(ActivatableAbilities.Items[Index].Handle, Index);
+	}
+	bSpecHandleIndexDirty = false;
+}
+
+void UCrimAbilitySystemComponent::AddAbilitySpecToDynamicTagIndex(const FGameplayAbilitySpec& AbilitySpec)
+{
+	for (const FGameplayTag& DynamicTag : AbilitySpec.GetDynamicSpecSourceTags().GetGameplayTagParents())
+	{
+		DynamicTagToSpecHandles.FindOrAdd(DynamicTag).AddUnique(AbilitySpec.Handle);
+	}
+}
+
+void UCrimAbilitySystemComponent::RemoveAbilitySpecFromDynamicTagIndex(const FGameplayAbilitySpec& AbilitySpec)
+{
+	for (const FGameplayTag& DynamicTag : AbilitySpec.GetDynamicSpecSourceTags().GetGameplayTagParents())
+	{
+		if (TArray<FGameplayAbilitySpecHandle>* Handles = DynamicTagToSpecHandles.Find(DynamicTag))
+		{
+			Handles->Remove(AbilitySpec.Handle);
+			if (Handles->IsEmpty())
+			{
+				DynamicTagToSpecHandles.Remove(DynamicTag);
+			}
+		}
+	}
+}
+
+void UCrimAbilitySystemComponent::RebuildDynamicTagIndex()
+{
+	DynamicTagToSpecHandles.Reset();
+	for (const FGameplayAbilitySpec& AbilitySpec : ActivatableAbilities.Items)
+	{
+		if (AbilitySpec.Ability)
+		{
+			AddAbilitySpecToDynamicTagIndex(AbilitySpec);
+		}
+	}
+}
+
+void UCrimAbilitySystemComponent::ClientNotifyAbilitiesFailed_Implementation(const TArray<FCrimAbilityFailureNotify>& AbilityFailures)
+{
+	const UGameplayTagsManager& TagsManager = UGameplayTagsManager::Get();
+
+	FGameplayTagContainer FailureReason;
+	for (const FCrimAbilityFailureNotify& AbilityFailure : AbilityFailures)
+	{
+		FailureReason.Reset();
+		for (const uint16 NetIndex : AbilityFailure.FailureTagNetIndices)
+		{
+			const FGameplayTag Tag = FGameplayTag::RequestGameplayTag(TagsManager.GetTagNameFromNetIndex(NetIndex), false);
+			if (Tag.IsValid())
+			{
+				FailureReason.AddTagFast(Tag);
+			}
+		}
+
+		HandleAbilityFailed(AbilityFailure.Ability, FailureReason);
+	}
+}
+
+void UCrimAbilitySystemComponent::QueueAbilityFailedNotify(const UGameplayAbility* Ability, const FGameplayTagContainer& FailureReason)
+{
+	UWorld* World = GetWorld();
+	if (!World)
+	{
+		return;
+	}
+
+	const double Now = World->GetTimeSeconds();
+
+	// Drop the failures that are outside the window and look for a repeat of this one.
+	for (int32 Index = RecentAbilityFailures.Num() - 1; Index >= 0; --Index)
+	{
+		const FCrimRecentAbilityFailure& RecentFailure = RecentAbilityFailures[Index];
+		if (Now - RecentFailure.Time >= AbilityFailureNotifyWindow || !RecentFailure.Ability.IsValid())
+		{
+			RecentAbilityFailures.RemoveAtSwap(Index, EAllowShrinking::No);
+		}
+		else if (RecentFailure.Ability == Ability && RecentFailure.FailureReason == FailureReason)
+		{
+			++SuppressedAbilityFailureCount;
+			return;
+		}
+	}
+
+	if (AbilityFailureNotifyWindow > 0.f)
+	{
+		RecentAbilityFailures.Add({Ability, FailureReason, Now});
+	}
+
+	const UGameplayTagsManager& TagsManager = UGameplayTagsManager::Get();
+
+	FCrimAbilityFailureNotify& AbilityFailure = PendingAbilityFailures.AddDefaulted_GetRef();
+	AbilityFailure.Ability = Ability;
+	AbilityFailure.FailureTagNetIndices.Reserve(FailureReason.Num());
+	for (const FGameplayTag& Tag : FailureReason)
+	{
+		const FGameplayTagNetIndex NetIndex = TagsManager.GetNetIndexFromTag(Tag);
+		if (NetIndex != INVALID_TAGNETINDEX)
+		{
+			AbilityFailure.FailureTagNetIndices.Add(NetIndex);
+		}
+	}
+
+	if (!bAbilityFailureFlushPending)
+	{
+		bAbilityFailureFlushPending = true;
+		World->GetTimerManager().SetTimerForNextTick(FTimerDelegate::CreateUObject(this, &ThisClass::FlushAbilityFailedNotifies));
+	}
+}
+
+void UCrimAbilitySystemComponent::FlushAbilityFailedNotifies()
+{
+	bAbilityFailureFlushPending = false;
+
+	if (PendingAbilityFailures.IsEmpty())
+	{
+		return;
+	}
+
+	ClientNotifyAbilitiesFailed(PendingAbilityFailures);
+	PendingAbilityFailures.Reset();
 }
 
 void UCrimAbilitySystemComponent::HandleAbilityFailed(const UGameplayAbility* Ability, const FGameplayTagContainer& FailureReason)
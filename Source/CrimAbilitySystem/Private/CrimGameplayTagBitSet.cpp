@@ -0,0 +1,156 @@
+﻿// Copyright Soccertitan 2025
+
+
+#include "CrimGameplayTagBitSet.h"
+
+#include "CrimAbilityLogChannels.h"
+#include "GameplayTagsManager.h"
+#include "HAL/IConsoleManager.h"
+
+
+FCrimGameplayTagBitSetUniverse& FCrimGameplayTagBitSetUniverse::Get()
+{
+	static FCrimGameplayTagBitSetUniverse Universe;
+	return Universe;
+}
+
+bool FCrimGameplayTagBitSetUniverse::CompileExact(const FGameplayTagContainer& Tags, FCrimGameplayTagBitSet& OutBits)
+{
+	check(IsInGameThread());
+
+	OutBits.Reset();
+	for (const FGameplayTag& Tag : Tags)
+	{
+		int32 Bit;
+		if (const int32* ExistingBit = TagToBit.Find(Tag))
+		{
+			Bit = *ExistingBit;
+		}
+		else
+		{
+			if (TagToBit.Num() >= FCrimGameplayTagBitSet::NumBits)
+			{
+				if (!bWarnedFull)
+				{
+					UE_LOG(LogCrimAbilitySystem, Warning, TEXT("FCrimGameplayTagBitSetUniverse: More than %d tags are used by activation requirements, the remaining abilities use the tag container checks."), FCrimGameplayTagBitSet::NumBits);
+					bWarnedFull = true;
+				}
+				return false;
+			}
+
+			Bit = TagToBit.Num();
+			TagToBit.Add(Tag, Bit);
+			++Generation;
+		}
+
+		OutBits.SetBit(Bit);
+	}
+	return true;
+}
+
+void FCrimGameplayTagBitSetUniverse::CompileWithParents(const FGameplayTagContainer& Tags, FCrimGameplayTagBitSet& OutBits) const
+{
+	OutBits.Reset();
+	if (TagToBit.IsEmpty())
+	{
+		return;
+	}
+
+	for (const FGameplayTag& OwnedTag : Tags)
+	{
+		for (FGameplayTag Tag = OwnedTag; Tag.IsValid(); Tag = Tag.RequestDirectParent())
+		{
+			if (const int32* Bit = TagToBit.Find(Tag))
+			{
+				OutBits.SetBit(*Bit);
+			}
+		}
+	}
+}
+
+#if !UE_BUILD_SHIPPING
+
+namespace CrimGameplayTagBitSet
+{
+	/** Compares the bit set checks against the tag container checks over the registered gameplay tags. */
+	static void RunBenchmark(const TArray<FString>& Args)
+	{
+		const int32 Iterations = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 100000;
+
+		FGameplayTagContainer AllTags;
+		UGameplayTagsManager::Get().RequestAllGameplayTags(AllTags, true);
+		TArray<FGameplayTag> TagArray;
+		AllTags.GetGameplayTagArray(TagArray);
+		if (TagArray.Num() < 8)
+		{
+			UE_LOG(LogCrimAbilitySystem, Display, TEXT("TagBitSetBenchmark: Needs at least 8 registered gameplay tags."));
+			return;
+		}
+
+		// Build a few owned and requirement sets from a fixed seed so the runs are comparable.
+		constexpr int32 NumSets = 16;
+		FRandomStream Random(1234);
+		FGameplayTagContainer OwnedTags[NumSets];
+		FGameplayTagContainer RequirementTags[NumSets];
+		for (int32 SetIndex = 0; SetIndex < NumSets; ++SetIndex)
+		{
+			for (int32 Count = 0; Count < 12; ++Count)
+			{
+				OwnedTags[SetIndex].AddTag(TagArray[Random.RandHelper(TagArray.Num())]);
+			}
+			for (int32 Count = 0; Count < 3; ++Count)
+			{
+				RequirementTags[SetIndex].AddTag(TagArray[Random.RandHelper(TagArray.Num())]);
+			}
+		}
+
+		// Benchmark against a separate universe so the plugin's bits are left alone.
+		FCrimGameplayTagBitSetUniverse Universe;
+		FCrimGameplayTagBitSet OwnedBits[NumSets];
+		FCrimGameplayTagBitSet RequirementBits[NumSets];
+		for (int32 SetIndex = 0; SetIndex < NumSets; ++SetIndex)
+		{
+			if (!Universe.CompileExact(RequirementTags[SetIndex], RequirementBits[SetIndex]))
+			{
+				UE_LOG(LogCrimAbilitySystem, Display, TEXT("TagBitSetBenchmark: Requirement tags do not fit in the bit set."));
+				return;
+			}
+		}
+		for (int32 SetIndex = 0; SetIndex < NumSets; ++SetIndex)
+		{
+			Universe.CompileWithParents(OwnedTags[SetIndex], OwnedBits[SetIndex]);
+		}
+
+		int32 ContainerMatches = 0;
+		const double ContainerStart = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			const int32 OwnedIndex = Iteration % NumSets;
+			const int32 RequirementIndex = (Iteration / NumSets) % NumSets;
+			ContainerMatches += OwnedTags[OwnedIndex].HasAny(RequirementTags[RequirementIndex]) ? 1 : 0;
+			ContainerMatches += OwnedTags[OwnedIndex].HasAll(RequirementTags[RequirementIndex]) ? 1 : 0;
+		}
+		const double ContainerSeconds = FPlatformTime::Seconds() - ContainerStart;
+
+		int32 BitSetMatches = 0;
+		const double BitSetStart = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			const int32 OwnedIndex = Iteration % NumSets;
+			const int32 RequirementIndex = (Iteration / NumSets) % NumSets;
+			BitSetMatches += OwnedBits[OwnedIndex].HasAny(RequirementBits[RequirementIndex]) ? 1 : 0;
+			BitSetMatches += OwnedBits[OwnedIndex].HasAll(RequirementBits[RequirementIndex]) ? 1 : 0;
+		}
+		const double BitSetSeconds = FPlatformTime::Seconds() - BitSetStart;
+
+		UE_LOG(LogCrimAbilitySystem, Display, TEXT("TagBitSetBenchmark: %d iterations. Containers %.3f ms (%d matches), bit sets %.3f ms (%d matches)."),
+			Iterations, ContainerSeconds * 1000.0, ContainerMatches, BitSetSeconds * 1000.0, BitSetMatches);
+	}
+
+	static FAutoConsoleCommand BenchmarkCommand(
+		TEXT("CrimAbilitySystem.TagBitSetBenchmark"),
+		TEXT("Compares FCrimGameplayTagBitSet HasAny/HasAll against FGameplayTagContainer. Usage: CrimAbilitySystem.TagBitSetBenchmark [Iterations]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&RunBenchmark));
+}
+
+#endif // !UE_BUILD_SHIPPING
@@ -6,6 +6,8 @@
 #include "GameplayAbilitySpec.h"
 #include "Abilities/GameplayAbility.h"
 #include "CrimAbilitySystemComponent.h"
+#include "CrimAbilitySystemInterface.h"
+#include "GameFramework/Actor.h"
 
 void FGlobalAppliedAbilityList::AddToAbilitySystemComponent(TSubclassOf<UGameplayAbility> Ability, UCrimAbilitySystemComponent* AbilitySystemComponent)
 {
@@ -126,9 +128,28 @@ void UCrimGlobalAbilitySystem::RegisterAbilitySystemComponent(UCrimAbilitySystem
 {
 	check(AbilitySystemComponent);
 
+	// Grant all the global abilities as one batch.
+	TArray<FGameplayAbilitySpec> AbilitySpecs;
+	TArray<FGlobalAppliedAbilityList*, TInlineAllocator<8>> AbilityLists;
+	AbilitySpecs.Reserve(AppliedAbilities.Num());
 	for (auto& Entry : AppliedAbilities)
 	{
-		Entry.Value.AddToAbilitySystemComponent(Entry.Key, AbilitySystemComponent);
+		Entry.Value.RemoveFromAbilitySystemComponent(AbilitySystemComponent);
+		AbilitySpecs.Emplace(Entry.Key->GetDefaultObject<UGameplayAbility>());
+		AbilityLists.Add(&Entry.Value);
+	}
+
+	if (!AbilitySpecs.IsEmpty())
+	{
+		TArray<FGameplayAbilitySpecHandle> AbilitySpecHandles;
+		AbilitySystemComponent->GiveAbilities(AbilitySpecs, &AbilitySpecHandles);
+		for (int32 Index = 0; Index < AbilitySpecHandles.Num(); ++Index)
+		{
+			if (AbilitySpecHandles[Index].IsValid())
+			{
+				AbilityLists[Index]->Handles.Add(AbilitySystemComponent, AbilitySpecHandles[Index]);
+			}
+		}
 	}
 	for (auto& Entry : AppliedEffects)
 	{
@@ -141,10 +162,22 @@ void UCrimGlobalAbilitySystem::RegisterAbilitySystemComponent(UCrimAbilitySystem
 void UCrimGlobalAbilitySystem::UnregisterAbilitySystemComponent(UCrimAbilitySystemComponent* AbilitySystemComponent)
 {
 	check(AbilitySystemComponent);
+
+	// Remove all the global abilities as one batch.
+	TArray<FGameplayAbilitySpecHandle, TInlineAllocator<8>> AbilitySpecHandles;
 	for (auto& Entry : AppliedAbilities)
 	{
-		Entry.Value.RemoveFromAbilitySystemComponent(AbilitySystemComponent);
+		FGameplayAbilitySpecHandle AbilitySpecHandle;
+		if (Entry.Value.Handles.RemoveAndCopyValue(AbilitySystemComponent, AbilitySpecHandle))
+		{
+			AbilitySpecHandles.Add(AbilitySpecHandle);
+		}
+	}
+	if (!AbilitySpecHandles.IsEmpty())
+	{
+		AbilitySystemComponent->ClearAbilities(AbilitySpecHandles);
 	}
+
 	for (auto& Entry : AppliedEffects)
 	{
 		Entry.Value.RemoveFromAbilitySystemComponent(AbilitySystemComponent);
@@ -152,3 +185,104 @@ void UCrimGlobalAbilitySystem::UnregisterAbilitySystemComponent(UCrimAbilitySyst
 
 	RegisteredAbilitySystemComponents.Remove(AbilitySystemComponent);
 }
+
+void UCrimGlobalAbilitySystem::RegisterAbilitySystemInterfaceComponent(UActorComponent* Component)
+{
+	if (!Component || !Component->Implements<UCrimAbilitySystemInterface>() || !Component->GetOwner())
+	{
+		return;
+	}
+
+	FindOrAddInterfaceComponents(Component->GetOwner()).Components.AddUnique(Component);
+}
+
+void UCrimGlobalAbilitySystem::UnregisterAbilitySystemInterfaceComponent(UActorComponent* Component)
+{
+	if (!Component || !Component->GetOwner())
+	{
+		return;
+	}
+
+	if (FCrimAbilitySystemInterfaceComponents* Entry = InterfaceComponentsByActor.Find(Component->GetOwner()))
+	{
+		Entry->Components.RemoveSingleSwap(Component);
+	}
+}
+
+void UCrimGlobalAbilitySystem::ForEachAbilitySystemInterfaceComponent(AActor* Actor, TFunctionRef<void(UActorComponent* Component)> Func)
+{
+	if (!Actor)
+	{
+		return;
+	}
+
+	FCrimAbilitySystemInterfaceComponents& Entry = FindOrAddInterfaceComponents(Actor);
+	if (!Entry.bScanned)
+	{
+		Actor->ForEachComponent(false, [&Entry](UActorComponent* Component)
+		{
+			if (Component->Implements<UCrimAbilitySystemInterface>())
+			{
+				Entry.Components.AddUnique(Component);
+			}
+		});
+		Entry.bScanned = true;
+	}
+
+	// Drop the components that were destroyed or moved to another actor.
+	Entry.Components.RemoveAll([Actor](const TWeakObjectPtr<UActorComponent>& Component)
+	{
+		return !Component.IsValid() || Component->GetOwner() != Actor;
+	});
+
+	// Copy the list since initializing a component can register other components.
+	TArray<UActorComponent*, TInlineAllocator<8>> Components;
+	for (const TWeakObjectPtr<UActorComponent>& Component : Entry.Components)
+	{
+		Components.Add(Component.Get());
+	}
+
+	for (UActorComponent* Component : Components)
+	{
+		Func(Component);
+	}
+}
+
+FCrimAbilitySystemInterfaceComponents& UCrimGlobalAbilitySystem::FindOrAddInterfaceComponents(AActor* Actor)
+{
+	check(Actor);
+
+	if (FCrimAbilitySystemInterfaceComponents* Entry = InterfaceComponentsByActor.Find(Actor))
+	{
+		return *Entry;
+	}
+
+	if (InterfaceComponentsByActor.Num() >= InterfaceComponentsPruneThreshold)
+	{
+		PruneInterfaceComponents();
+	}
+
+	Actor->OnEndPlay.AddUniqueDynamic(this, &UCrimGlobalAbilitySystem::HandleActorEndPlay);
+	FCrimAbilitySystemInterfaceComponents& Entry = InterfaceComponentsByActor.Add(Actor);
+	Entry.Actor = Actor;
+	return Entry;
+}
+
+void UCrimGlobalAbilitySystem::PruneInterfaceComponents()
+{
+	for (auto It = InterfaceComponentsByActor.CreateIterator(); It; ++It)
+	{
+		if (!It.Value().Actor.IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	// Prune again once the live entries doubled, so the sweeps stay amortized over the additions.
+	InterfaceComponentsPruneThreshold = FMath::Max(64, InterfaceComponentsByActor.Num() * 2);
+}
+
+void UCrimGlobalAbilitySystem::HandleActorEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason)
+{
+	InterfaceComponentsByActor.Remove(Actor);
+}
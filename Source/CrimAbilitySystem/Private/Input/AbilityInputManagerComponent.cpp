@@ -94,7 +94,7 @@ void UAbilityInputManagerComponent::ProcessAbilityInput(float DeltaTime, bool bG
 	//
 	for (const FGameplayAbilitySpecHandle& SpecHandle : InputHeldSpecHandles)
 	{
-		if (const FGameplayAbilitySpec* AbilitySpec = AbilitySystemComponent->FindAbilitySpecFromHandle(SpecHandle))
+		if (const FGameplayAbilitySpec* AbilitySpec = AbilitySystemComponent->GetAbilitySpecByHandle(SpecHandle))
 		{
 			if (AbilitySpec->Ability && !AbilitySpec->IsActive())
 			{
@@ -112,7 +112,7 @@ void UAbilityInputManagerComponent::ProcessAbilityInput(float DeltaTime, bool bG
 	//
 	for (const FGameplayAbilitySpecHandle& SpecHandle : InputPressedSpecHandles)
 	{
-		if (FGameplayAbilitySpec* AbilitySpec = AbilitySystemComponent->FindAbilitySpecFromHandle(SpecHandle))
+		if (FGameplayAbilitySpec* AbilitySpec = AbilitySystemComponent->GetAbilitySpecByHandle(SpecHandle))
 		{
 			if (AbilitySpec->Ability)
 			{
@@ -157,7 +157,7 @@ void UAbilityInputManagerComponent::ProcessAbilityInput(float DeltaTime, bool bG
 	//
 	for (const FGameplayAbilitySpecHandle& SpecHandle : InputReleasedSpecHandles)
 	{
-		if (FGameplayAbilitySpec* AbilitySpec = AbilitySystemComponent->FindAbilitySpecFromHandle(SpecHandle))
+		if (FGameplayAbilitySpec* AbilitySpec = AbilitySystemComponent->GetAbilitySpecByHandle(SpecHandle))
 		{
 			if (AbilitySpec->Ability)
 			{
@@ -355,29 +355,20 @@ void UAbilityInputManagerComponent::ReleaseAbilityInput()
 
 void UAbilityInputManagerComponent::Internal_InputPressed(const TSoftClassPtr<UGameplayAbility>& AbilityClass)
 {
-	FScopedAbilityListLock ActiveScopeLock(*AbilitySystemComponent);
-	for (const FGameplayAbilitySpec& AbilitySpec : AbilitySystemComponent->GetActivatableAbilities())
+	// Granted abilities are always loaded, so an unloaded class can't match any spec.
+	if (const FGameplayAbilitySpec* AbilitySpec = AbilitySystemComponent->GetAbilitySpecByClass(AbilityClass.Get()))
 	{
-		if (AbilitySpec.Ability && AbilitySpec.Ability->GetClass() == AbilityClass)
-		{
-			InputPressedSpecHandles.AddUnique(AbilitySpec.Handle);
-			InputHeldSpecHandles.AddUnique(AbilitySpec.Handle);
-			return;
-		}
+		InputPressedSpecHandles.AddUnique(AbilitySpec->Handle);
+		InputHeldSpecHandles.AddUnique(AbilitySpec->Handle);
 	}
 }
 
 void UAbilityInputManagerComponent::Internal_InputReleased(const TSoftClassPtr<UGameplayAbility>& AbilityClass)
 {
-	FScopedAbilityListLock ActiveScopeLock(*AbilitySystemComponent);
-	for (const FGameplayAbilitySpec& AbilitySpec : AbilitySystemComponent->GetActivatableAbilities())
+	if (const FGameplayAbilitySpec* AbilitySpec = AbilitySystemComponent->GetAbilitySpecByClass(AbilityClass.Get()))
 	{
-		if (AbilitySpec.Ability && AbilitySpec.Ability->GetClass() == AbilityClass)
-		{
-			InputReleasedSpecHandles.AddUnique(AbilitySpec.Handle);
-			InputHeldSpecHandles.Remove(AbilitySpec.Handle);
-			return;
-		}
+		InputReleasedSpecHandles.AddUnique(AbilitySpec->Handle);
+		InputHeldSpecHandles.Remove(AbilitySpec->Handle);
 	}
 }
 
@@ -22,7 +22,7 @@ void UGamePhaseSubsystem::StartPhase(TSubclassOf<UGamePhaseGameplayAbility> Phas
 	{
 		FGameplayAbilitySpec PhaseSpec(PhaseAbility, 1, 0, this);
 		FGameplayAbilitySpecHandle SpecHandle = GameState_ASC->GiveAbilityAndActivateOnce(PhaseSpec);
-		FGameplayAbilitySpec* FoundSpec = GameState_ASC->FindAbilitySpecFromHandle(SpecHandle);
+		FGameplayAbilitySpec* FoundSpec = GameState_ASC->GetAbilitySpecByHandle(SpecHandle);
 		
 		if (FoundSpec && FoundSpec->IsActive())
 		{
@@ -125,7 +125,7 @@ void UGamePhaseSubsystem::OnBeginPhase(const UGamePhaseGameplayAbility* PhaseAbi
 		for (const auto& KVP : ActivePhaseMap)
 		{
 			const FGameplayAbilitySpecHandle ActiveAbilityHandle = KVP.Key;
-			if (FGameplayAbilitySpec* Spec = GameState_ASC->FindAbilitySpecFromHandle(ActiveAbilityHandle))
+			if (FGameplayAbilitySpec* Spec = GameState_ASC->GetAbilitySpecByHandle(ActiveAbilityHandle))
 			{
 				ActivePhases.Add(Spec);
 			}
@@ -0,0 +1,100 @@
+﻿// Copyright Soccertitan 2025
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayAbilitySpecHandle.h"
+#include "Net/Serialization/FastArraySerializer.h"
+#include "AbilityChargeTypes.generated.h"
+
+class UCrimAbilitySystemComponent;
+struct FAbilityChargeContainer;
+
+/**
+ * The charges of an ability spec. Only the count at the last refill is stored, the current count is computed from the
+ * time passed since then.
+ */
+USTRUCT()
+struct CRIMABILITYSYSTEM_API FAbilityChargeItem : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	// The ability spec the charges belong to.
+	UPROPERTY()
+	FGameplayAbilitySpecHandle Handle;
+
+	// Charges at LastRefillTime.
+	UPROPERTY()
+	int32 Charges = 0;
+
+	// Server world time the last charge was refilled at, or the recharge started at.
+	UPROPERTY()
+	double LastRefillTime = 0.0;
+
+	// Seconds to refill one charge. Zero never refills.
+	UPROPERTY()
+	float RechargePeriod = 0.f;
+
+	/** Returns the charges at Time. */
+	int32 GetCharges(double Time, int32 MaxCharges) const;
+
+	/** Returns the seconds until the next charge refills at Time, zero when full or never refilled. */
+	float GetTimeUntilNextCharge(double Time, int32 MaxCharges) const;
+
+	/** Returns the seconds until at least Count charges are available at Time, zero if they are or never will be. */
+	float GetTimeUntilCharges(double Time, int32 Count, int32 MaxCharges) const;
+
+	/** Spends Count charges at Time, keeping the progress towards the next charge. */
+	void Consume(double Time, int32 Count, int32 MaxCharges, float InRechargePeriod);
+
+	void PostReplicatedAdd(const FAbilityChargeContainer& InArraySerializer);
+	void PostReplicatedChange(const FAbilityChargeContainer& InArraySerializer);
+	void PreReplicatedRemove(const FAbilityChargeContainer& InArraySerializer);
+};
+
+/**
+ * A FastArray of the charges of the ability specs that used at least one. Specs without an item have all their charges.
+ */
+USTRUCT()
+struct CRIMABILITYSYSTEM_API FAbilityChargeContainer : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	/** Spends Count charges of the ability spec at Time. Authority only. */
+	void Consume(FGameplayAbilitySpecHandle Handle, double Time, int32 Count, int32 MaxCharges, float RechargePeriod);
+
+	/** Removes the charges of the ability spec. Authority only. */
+	void Remove(FGameplayAbilitySpecHandle Handle);
+
+	/** Returns the charges of the ability spec, null if it never used one. */
+	const FAbilityChargeItem* Find(FGameplayAbilitySpecHandle Handle) const;
+
+	void RegisterWithOwner(UCrimAbilitySystemComponent* InOwner);
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParams)
+	{
+		return FastArrayDeltaSerialize<FAbilityChargeItem, FAbilityChargeContainer>(Items, DeltaParams, *this);
+	}
+
+private:
+	UPROPERTY()
+	TArray<FAbilityChargeItem> Items;
+
+	// Not a UPROPERTY so the archetype's owner isn't copied over it, see UCrimAbilitySystemComponent::PostInitProperties.
+	UCrimAbilitySystemComponent* Owner = nullptr;
+
+	// Index of each handle in Items. Rebuilt on the next lookup after Items changed.
+	mutable TMap<FGameplayAbilitySpecHandle, int32> HandleToIndex;
+	mutable bool bHandleIndexDirty = true;
+
+	friend struct FAbilityChargeItem;
+};
+
+template<>
+struct TStructOpsTypeTraits<FAbilityChargeContainer> : public TStructOpsTypeTraitsBase2<FAbilityChargeContainer>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true
+	};
+};
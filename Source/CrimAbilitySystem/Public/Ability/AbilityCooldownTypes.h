@@ -0,0 +1,82 @@
+﻿// Copyright Soccertitan 2025
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "Net/Serialization/FastArraySerializer.h"
+#include "AbilityCooldownTypes.generated.h"
+
+class UCrimAbilitySystemComponent;
+struct FAbilityCooldownContainer;
+
+/**
+ * A cooldown tracked by its end time instead of an active gameplay effect.
+ */
+USTRUCT()
+struct CRIMABILITYSYSTEM_API FAbilityCooldownItem : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	// The cooldown tag granted until EndTime.
+	UPROPERTY()
+	FGameplayTag CooldownTag;
+
+	// Server world time the cooldown ends at.
+	UPROPERTY()
+	double EndTime = 0.0;
+
+	// Total duration of the cooldown.
+	UPROPERTY()
+	float Duration = 0.f;
+
+	void PostReplicatedAdd(const FAbilityCooldownContainer& InArraySerializer);
+	void PostReplicatedChange(const FAbilityCooldownContainer& InArraySerializer);
+	void PreReplicatedRemove(const FAbilityCooldownContainer& InArraySerializer);
+};
+
+/**
+ * A FastArray of the cooldowns applied through UCrimAbilitySystemComponent::ApplyNativeCooldown. Only holds the
+ * running cooldowns, expired ones are removed by the server.
+ */
+USTRUCT()
+struct CRIMABILITYSYSTEM_API FAbilityCooldownContainer : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	/** Starts the cooldown of the tag, or extends it if it is already running and ends earlier. */
+	void SetCooldown(const FGameplayTag& CooldownTag, double EndTime, float Duration);
+
+	/** Removes the cooldowns that ended at or before Time. */
+	void RemoveExpiredCooldowns(double Time);
+
+	/** Returns the cooldown of the tag, null if it is not on cooldown. */
+	const FAbilityCooldownItem* FindCooldown(const FGameplayTag& CooldownTag) const;
+
+	const TArray<FAbilityCooldownItem>& GetItems() const { return Items; }
+
+	void RegisterWithOwner(UCrimAbilitySystemComponent* InOwner);
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParams)
+	{
+		return FastArrayDeltaSerialize<FAbilityCooldownItem, FAbilityCooldownContainer>(Items, DeltaParams, *this);
+	}
+
+private:
+	UPROPERTY()
+	TArray<FAbilityCooldownItem> Items;
+
+	// Not a UPROPERTY so the archetype's owner isn't copied over it, see UCrimAbilitySystemComponent::PostInitProperties.
+	UCrimAbilitySystemComponent* Owner = nullptr;
+
+	friend struct FAbilityCooldownItem;
+};
+
+template<>
+struct TStructOpsTypeTraits<FAbilityCooldownContainer> : public TStructOpsTypeTraitsBase2<FAbilityCooldownContainer>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true
+	};
+};
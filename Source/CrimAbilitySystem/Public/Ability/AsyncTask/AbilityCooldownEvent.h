@@ -9,6 +9,7 @@
 #include "AbilityCooldownEvent.generated.h"
 
 class UAbilitySystemComponent;
+class UCrimAbilitySystemComponent;
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FAbilityCooldownEventSignature, float, TimeRemaining);
 
 /**
@@ -45,4 +46,5 @@ protected:
 
 	void CooldownTagChanged(const FGameplayTag InCooldownTag, int32 NewCount);
 	void OnActiveEffectAdded(UAbilitySystemComponent* TargetAbilitySystemComponent, const FGameplayEffectSpec& SpecApplied, FActiveGameplayEffectHandle ActiveEffectHandle);
+	void OnNativeCooldownApplied(UCrimAbilitySystemComponent* CrimAbilitySystemComponent, const FGameplayTag& InCooldownTag, float TimeRemaining, float Duration);
 };
@@ -7,8 +7,42 @@
 #include "UObject/Object.h"
 #include "AbilityCost.generated.h"
 
+class UAbilityCost;
 class UGameplayAbility;
 
+/** What a cost computed for an activation, so CommitAbility doesn't repeat the work CanActivateAbility did. */
+struct FAbilityCostEvaluation
+{
+	/** The amount the cost spends, unset until it was computed. */
+	TOptional<float> Amount;
+
+	/** Whether CheckCost passed, unset until it ran. */
+	TOptional<bool> bCanAfford;
+
+	/** The failure tags CheckCost added, added again when the cached result is reused. */
+	FGameplayTagContainer FailureTags;
+};
+
+/**
+ * The cost results of an ability spec for its current activation. CanActivateAbility and CommitAbility both check the
+ * costs, usually in the same frame, and ApplyCost follows them. The ability system component keeps one context per
+ * spec and resets it on a new frame, once any cost was applied or once an attribute read by the spec's costs changed.
+ */
+struct CRIMABILITYSYSTEM_API FAbilityCostEvaluationContext
+{
+	/** Returns the evaluation of the cost, a null Cost stands for the ability's cost gameplay effect. */
+	FAbilityCostEvaluation& FindOrAdd(const UAbilityCost* Cost);
+
+	/** Drops the results and stamps the context with the frame and generation it is valid for. */
+	void Reset(uint64 InFrameCounter, uint32 InGeneration);
+
+	uint64 FrameCounter = 0;
+	uint32 Generation = 0;
+
+private:
+	TArray<TPair<const UAbilityCost*, FAbilityCostEvaluation>, TInlineAllocator<4>> Evaluations;
+};
+
 /**
  * Base class for costs that a CrimGameplayAbility has (e.g., charges, attributes)
  */
@@ -27,6 +61,7 @@ public:
 	 * elsewhere to determine how to provide user feedback (e.g., a clicking noise if a weapon is out of ammo)
 	 * 
 	 * Ability and ActorInfo are guaranteed to be non-null on entry, but OptionalRelevantTags can be nullptr.
+	 * CrimGameplayAbility caches the result for the activation, see FAbilityCostEvaluationContext.
 	 * 
 	 * @return true if we can pay for the ability, false otherwise.
 	 */
@@ -49,6 +84,16 @@ public:
 	/** If true, this cost should only be applied if this ability hits successfully */
 	bool ShouldOnlyApplyCostOnHit() const { return bOnlyApplyCostOnHit; }
 
+	/**
+	 * Adds the attributes that CheckCost reads. The ability availability cache re-checks the ability when they change.
+	 */
+	virtual void GetRelevantAttributes(TArray<FGameplayAttribute>& OutAttributes) const
+	{
+	}
+
+	/** Returns this cost's evaluation for the current activation of the spec, null if the ability system can't cache it. */
+	FAbilityCostEvaluation* FindCostEvaluation(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo) const;
+
 protected:
 	/** If true, this cost should only be applied if this ability hits successfully */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Costs)
@@ -0,0 +1,43 @@
+﻿// Copyright Soccertitan 2025
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AbilityCost.h"
+#include "AttributeSet.h"
+#include "GameplayTagContainer.h"
+#include "ScalableFloat.h"
+#include "AbilityCost_Attribute.generated.h"
+
+/**
+ * Spends an attribute, e.g. ResourcePoints, by lowering its base value directly instead of applying a cost GE. The
+ * attribute set's ClampAttributes still applies. Clients predict the spend and restore it if the activation is rejected.
+ */
+UCLASS(meta = (DisplayName = "Attribute"))
+class CRIMABILITYSYSTEM_API UAbilityCost_Attribute : public UAbilityCost
+{
+	GENERATED_BODY()
+
+public:
+	//~UAbilityCost interface
+	virtual bool CheckCost(const UGameplayAbility* Ability, const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, FGameplayTagContainer* OptionalRelevantTags) const override;
+	virtual void ApplyCost(const UGameplayAbility* Ability, const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilityActivationInfo ActivationInfo) override;
+	virtual void GetRelevantAttributes(TArray<FGameplayAttribute>& OutAttributes) const override;
+	//~End of UAbilityCost interface
+
+	/** Returns the amount spent at the ability's level. */
+	float GetCostAmount(const UGameplayAbility* Ability, const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo) const;
+
+protected:
+	/** The attribute to spend. */
+	UPROPERTY(EditAnywhere, Category = Costs)
+	FGameplayAttribute Attribute;
+
+	/** The amount to spend, scaled by the ability level. */
+	UPROPERTY(EditAnywhere, Category = Costs)
+	FScalableFloat Cost;
+
+	/** Tag added to OptionalRelevantTags when the attribute is too low. The ability system's cost fail tag if not set. */
+	UPROPERTY(EditAnywhere, Category = Costs)
+	FGameplayTag FailureTag;
+};
@@ -0,0 +1,44 @@
+﻿// Copyright Soccertitan 2025
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AbilityCost.h"
+#include "GameplayTagContainer.h"
+#include "AbilityCost_Charges.generated.h"
+
+/**
+ * Spends charges that refill one at a time over RechargePeriod. The charges are stored per ability spec on the
+ * CrimAbilitySystemComponent and computed from the last refill time when read, nothing ticks while they refill.
+ */
+UCLASS(meta = (DisplayName = "Charges"))
+class CRIMABILITYSYSTEM_API UAbilityCost_Charges : public UAbilityCost
+{
+	GENERATED_BODY()
+
+public:
+	//~UAbilityCost interface
+	virtual bool CheckCost(const UGameplayAbility* Ability, const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, FGameplayTagContainer* OptionalRelevantTags) const override;
+	virtual void ApplyCost(const UGameplayAbility* Ability, const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilityActivationInfo ActivationInfo) override;
+	//~End of UAbilityCost interface
+
+	int32 GetMaxCharges() const { return MaxCharges; }
+	int32 GetChargesPerUse() const { return ChargesPerUse; }
+
+protected:
+	/** Charges the ability holds when full. */
+	UPROPERTY(EditAnywhere, Category = Costs, meta = (ClampMin = "1"))
+	int32 MaxCharges = 1;
+
+	/** Seconds to refill one charge. Zero never refills. */
+	UPROPERTY(EditAnywhere, Category = Costs, meta = (ClampMin = "0.0"))
+	float RechargePeriod = 1.f;
+
+	/** Charges spent per activation. */
+	UPROPERTY(EditAnywhere, Category = Costs, meta = (ClampMin = "1"))
+	int32 ChargesPerUse = 1;
+
+	/** Tag added to OptionalRelevantTags when there aren't enough charges. Ability.ActivateFail.Charges if not set. */
+	UPROPERTY(EditAnywhere, Category = Costs)
+	FGameplayTag FailureTag;
+};
@@ -53,10 +53,17 @@ class CRIMABILITYSYSTEM_API UCrimGameplayAbility : public UGameplayAbility
 {
 	GENERATED_BODY()
 	friend class UCrimAbilitySystemComponent;
+	friend class UAbilityInteractionMatrix;
 
 public:
 	UCrimGameplayAbility(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
 
+	virtual void PostInitProperties() override;
+	virtual void PostLoad() override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
 	UFUNCTION(BlueprintCallable, Category = "Crim Ability System|Ability")
 	UCrimAbilitySystemComponent* GetCrimAbilitySystemComponentFromActorInfo() const;
 
@@ -106,6 +113,8 @@ protected:
 	virtual void ApplyCost(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilityActivationInfo ActivationInfo) const override;
 	virtual const FGameplayTagContainer* GetCooldownTags() const override;
 	virtual void ApplyCooldown(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilityActivationInfo ActivationInfo) const override;
+	virtual bool CheckCooldown(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, OUT FGameplayTagContainer* OptionalRelevantTags = nullptr) const override;
+	virtual void GetCooldownTimeRemainingAndDuration(FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, float& TimeRemaining, float& CooldownDuration) const override;
 	virtual FGameplayEffectContextHandle MakeEffectContext(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo) const override;
 	virtual void ApplyAbilityTagsToGameplayEffectSpec(FGameplayEffectSpec& Spec, FGameplayAbilitySpec* AbilitySpec) const override;
 	virtual bool DoesAbilitySatisfyTagRequirements(const UAbilitySystemComponent& AbilitySystemComponent, const FGameplayTagContainer* SourceTags = nullptr, const FGameplayTagContainer* TargetTags = nullptr, OUT FGameplayTagContainer* OptionalRelevantTags = nullptr) const override;
@@ -147,6 +156,11 @@ protected:
 	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category = "Cooldowns", meta = (ClampMin = "0.0"))
 	float BaseCooldown = 0.f;
 
+	// If true, the cooldown is tracked as end times on the CrimAbilitySystemComponent instead of applying the cooldown GE.
+	// The cooldown tags are still granted while it runs.
+	UPROPERTY(EditDefaultsOnly, Category = "Cooldowns")
+	bool bUseNativeCooldown = false;
+
 	// Returns the actual cooldown for the ability.
 	UFUNCTION(BlueprintPure, BlueprintNativeEvent, Category = "Crim Ability System|Ability")
 	float GetCooldown() const;
@@ -160,10 +174,21 @@ protected:
 	bool bLogCancelation;
 
 private:
+	// Returns the cooldown spec without the duration set, reusing the cached one when it is still valid.
+	FGameplayEffectSpecHandle GetCooldownSpec(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilityActivationInfo ActivationInfo, const UGameplayEffect& CooldownGE) const;
+
+	// Rebuilds CompiledCooldownTags. Only called on the CDO.
+	void CompileCooldownTags();
+
 	/**
-	 * Temp container that we will return the pointer to in GetCooldownTags().
-	 * This will be the union of our CooldownTags and the Cooldown GE's cooldown tags.
+	 * The union of our CooldownTags and the Cooldown GE's granted tags returned by GetCooldownTags().
+	 * Only the CDO builds it, when it is initialized or loaded and when it is edited, and instances read it from there.
 	 */
-	UPROPERTY(Transient)
-	FGameplayTagContainer TransientCooldownTags;
+	FGameplayTagContainer CompiledCooldownTags;
+
+	// Cooldown spec built by ApplyCooldown. Instances reuse it while the ASC, level and dynamic tags of the spec stay the same.
+	mutable FGameplayEffectSpecHandle CachedCooldownSpec;
+	mutable TWeakObjectPtr<const UAbilitySystemComponent> CachedCooldownAbilitySystem;
+	mutable FGameplayTagContainer CachedCooldownDynamicTags;
+	mutable int32 CachedCooldownLevel = INDEX_NONE;
 };
@@ -32,6 +32,7 @@ public:
 	 * Ability Tags
 	 */
 	FGameplayTag Ability_ActivateFail_ActivationGroup;
+	FGameplayTag Ability_ActivateFail_Charges;
 	FGameplayTag Ability_ActivateFail_IsDead;
 	FGameplayTag Ability_Cooldown;
 	FGameplayTag Ability_GameplayEvent_Death;
@@ -0,0 +1,117 @@
+﻿// Copyright Soccertitan 2025
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "GameplayTagContainer.h"
+#include "AbilityInteractionMatrix.generated.h"
+
+class UAbilitySet;
+class UAbilityTagRelationshipMapping;
+class UGameplayAbility;
+
+/** The abilities one ability class blocks and cancels, resolved from their tags and the tag relationship mapping. */
+USTRUCT()
+struct FAbilityInteraction
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleAnywhere, Category = Ability)
+	TSubclassOf<UGameplayAbility> Ability;
+
+	/** The asset tags of Ability when the matrix was built. */
+	UPROPERTY(VisibleAnywhere, Category = Ability)
+	FGameplayTagContainer AssetTags;
+
+	/** The cancel tags of Ability when the matrix was built, before the mapping expanded them. */
+	UPROPERTY(VisibleAnywhere, Category = Ability)
+	FGameplayTagContainer CancelTags;
+
+	/** Abilities blocked while Ability is active. Blocking still goes through the blocked ability tags at runtime. */
+	UPROPERTY(VisibleAnywhere, Category = Ability)
+	TArray<TSubclassOf<UGameplayAbility>> BlockedAbilities;
+
+	/** Abilities canceled when Ability activates. */
+	UPROPERTY(VisibleAnywhere, Category = Ability)
+	TArray<TSubclassOf<UGameplayAbility>> CanceledAbilities;
+};
+
+/**
+ * The block and cancel relations between the abilities of the ability sets for one tag relationship mapping, resolved
+ * offline by Build. Built by the AbilityInteractionMatrix commandlet and when cooked. An ASC using the same mapping
+ * cancels the listed abilities directly instead of matching the cancel tags, as long as every ability it was granted
+ * is in the matrix.
+ */
+UCLASS(Const)
+class CRIMABILITYSYSTEM_API UAbilityInteractionMatrix : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	//~UObject interface
+	virtual void PostLoad() override;
+#if WITH_EDITOR
+	virtual void PreSave(FObjectPreSaveContext ObjectSaveContext) override;
+#endif
+	//~End of UObject interface
+
+	/**
+	 * Resolves the interactions between every UCrimGameplayAbility of the ability sets.
+	 * @param OutIssues Filled with unreachable or contradictory rules, if set.
+	 */
+	void Build(TArray<FString>* OutIssues = nullptr);
+
+	/** Returns the interactions of the ability class, null if it wasn't part of the build. */
+	const FAbilityInteraction* FindInteraction(const UClass* AbilityClass) const;
+
+	/**
+	 * Returns the interactions of the ability class if the ability still has the asset and cancel tags it was built
+	 * with, null otherwise.
+	 */
+	const FAbilityInteraction* FindInteraction(const UGameplayAbility& Ability) const;
+
+	UAbilityTagRelationshipMapping* GetTagRelationshipMapping() const { return TagRelationshipMapping; }
+
+	/**
+	 * Returns false if the mapping or the tags of the abilities changed since the matrix was built. Only checked in the
+	 * editor, cooked matrices are rebuilt when they are saved.
+	 */
+	bool IsUpToDate() const;
+
+private:
+	// Rebuilds InteractionIndex from Interactions.
+	void RebuildInteractionIndex();
+
+	// Hashes the mapping's relationships and the current tags of the abilities in Interactions.
+	uint32 ComputeInputHash() const;
+
+	/** The mapping the interactions are resolved for. */
+	UPROPERTY(EditDefaultsOnly, Category = Ability)
+	TObjectPtr<UAbilityTagRelationshipMapping> TagRelationshipMapping;
+
+	/** The ability sets whose abilities are resolved against each other. */
+	UPROPERTY(EditDefaultsOnly, Category = Ability)
+	TArray<TObjectPtr<UAbilitySet>> AbilitySets;
+
+	/** Abilities to resolve that aren't granted through the ability sets. */
+	UPROPERTY(EditDefaultsOnly, Category = Ability)
+	TArray<TSubclassOf<UGameplayAbility>> AdditionalAbilities;
+
+	/** The resolved interactions, one per ability class. */
+	UPROPERTY(VisibleAnywhere, Category = Ability)
+	TArray<FAbilityInteraction> Interactions;
+
+	/** ComputeInputHash when the matrix was built. */
+	UPROPERTY()
+	uint32 InputHash = 0;
+
+	// Index into Interactions by ability class.
+	TMap<TObjectKey<UClass>, int32> InteractionIndex;
+
+#if WITH_EDITORONLY_DATA
+	// Result of the last IsUpToDate check and the frame it was made on. Edits only happen between frames.
+	mutable bool bUpToDate = true;
+	mutable uint64 UpToDateCheckFrame = 0;
+#endif
+};
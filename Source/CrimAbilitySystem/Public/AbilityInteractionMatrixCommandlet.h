@@ -0,0 +1,24 @@
+﻿// Copyright Soccertitan 2025
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "AbilityInteractionMatrixCommandlet.generated.h"
+
+/**
+ * Builds every AbilityInteractionMatrix asset and logs the unreachable or contradictory rules it found.
+ * Usage: -run=AbilityInteractionMatrix [-save]
+ */
+UCLASS()
+class UAbilityInteractionMatrixCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UAbilityInteractionMatrixCommandlet();
+
+	//~UCommandlet interface
+	virtual int32 Main(const FString& Params) override;
+	//~End of UCommandlet interface
+};
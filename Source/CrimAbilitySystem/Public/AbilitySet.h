@@ -151,6 +151,8 @@ public:
 	 * The returned handles can be used later to take away anything that was granted.
 	 */
 	void GiveToAbilitySystem(UAbilitySystemComponent* AbilitySystemComponent, FAbilitySet_GrantedHandles* OutGrantedHandles, UObject* SourceObject = nullptr) const;
+
+	const TArray<FAbilitySet_GameplayAbility>& GetGrantedGameplayAbilities() const { return GrantedGameplayAbilities; }
 	
 protected:
 
@@ -0,0 +1,70 @@
+﻿// Copyright Soccertitan 2025
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "Ability/CrimGameplayAbility.h"
+
+struct FGameplayAbilitySpec;
+class UCrimAbilitySystemComponent;
+
+/**
+ * A reusable query over the ability specs of a UCrimAbilitySystemComponent. Build it once and run it with
+ * UCrimAbilitySystemComponent::ForEachAbilitySpec or GetAbilitySpecs. All set conditions must match.
+ */
+struct CRIMABILITYSYSTEM_API FCrimAbilitySpecQuery
+{
+	/** The ability's AssetTags must have the tag. Parent tags match as well. */
+	FCrimAbilitySpecQuery& WithAssetTag(const FGameplayTag& Tag)
+	{
+		if (Tag.IsValid())
+		{
+			AssetTags.AddUnique(Tag);
+		}
+		return *this;
+	}
+
+	/** The spec's DynamicSpecSourceTags must have the tag. Parent tags match as well. */
+	FCrimAbilitySpecQuery& WithDynamicTag(const FGameplayTag& Tag)
+	{
+		if (Tag.IsValid())
+		{
+			DynamicTags.AddUnique(Tag);
+		}
+		return *this;
+	}
+
+	/** The spec's ability must be exactly this class. */
+	FCrimAbilitySpecQuery& WithClass(TSubclassOf<UGameplayAbility> InAbilityClass)
+	{
+		AbilityClass = InAbilityClass.Get();
+		return *this;
+	}
+
+	/** The spec must be active, or inactive when bActive is false. */
+	FCrimAbilitySpecQuery& WithActive(bool bActive = true)
+	{
+		ActiveState = bActive;
+		return *this;
+	}
+
+	/**
+	 * The spec's ability must be a UCrimGameplayAbility in the activation group. Running specs match the group any of their
+	 * running abilities is currently in. Other specs use their primary instance, or the CDO if there is none.
+	 */
+	FCrimAbilitySpecQuery& WithActivationGroup(EAbilityActivationGroup Group)
+	{
+		ActivationGroup = Group;
+		return *this;
+	}
+
+	/** Returns true if the spec of the ability system component passes every condition of the query. */
+	bool Matches(const UCrimAbilitySystemComponent& AbilitySystemComponent, const FGameplayAbilitySpec& AbilitySpec) const;
+
+	TArray<FGameplayTag, TInlineAllocator<2>> AssetTags;
+	TArray<FGameplayTag, TInlineAllocator<2>> DynamicTags;
+	const UClass* AbilityClass = nullptr;
+	TOptional<bool> ActiveState;
+	TOptional<EAbilityActivationGroup> ActivationGroup;
+};
@@ -34,6 +34,55 @@ struct FAbilityTagRelationship
 	FGameplayTagContainer ActivationBlockedTags;
 };
 
+/** The merged relationships of every row that uses the same AbilityTag */
+struct FAbilityTagRelationshipEntry
+{
+	FGameplayTagContainer AbilityTagsToBlock;
+	FGameplayTagContainer AbilityTagsToCancel;
+	FGameplayTagContainer ActivationRequiredTags;
+	FGameplayTagContainer ActivationBlockedTags;
+};
+
+/**
+ * Tag relationships compiled into a hash table keyed by AbilityTag. Lookups walk the ability tags and their parents,
+ * so the cost depends on the number of ability tags and not on the number of relationships.
+ */
+struct CRIMABILITYSYSTEM_API FAbilityTagRelationshipTable
+{
+	/** Rebuilds the table from the relationships. */
+	void Compile(TConstArrayView<FAbilityTagRelationship> Relationships);
+
+	/** Appends the entries of another table, merging the ones that use the same AbilityTag. */
+	void Merge(const FAbilityTagRelationshipTable& Other);
+
+	void GetAbilityTagsToBlockAndCancel(const FGameplayTagContainer& AbilityTags, FGameplayTagContainer* OutTagsToBlock, FGameplayTagContainer* OutTagsToCancel) const;
+	void GetRequiredAndBlockedActivationTags(const FGameplayTagContainer& AbilityTags, FGameplayTagContainer* OutActivationRequired, FGameplayTagContainer* OutActivationBlocked) const;
+	bool IsAbilityCancelledByTag(const FGameplayTagContainer& AbilityTags, const FGameplayTag& ActionTag) const;
+
+	/** Calls Func for each entry whose AbilityTag matches one of the ability tags, the same as AbilityTags.HasTag(AbilityTag). */
+	template<typename FuncType>
+	void ForEachMatchingEntry(const FGameplayTagContainer& AbilityTags, FuncType&& Func) const
+	{
+		if (Entries.IsEmpty())
+		{
+			return;
+		}
+
+		for (const FGameplayTag& AbilityTag : AbilityTags)
+		{
+			for (FGameplayTag Tag = AbilityTag; Tag.IsValid(); Tag = Tag.RequestDirectParent())
+			{
+				if (const FAbilityTagRelationshipEntry* Entry = Entries.Find(Tag))
+				{
+					Func(*Entry);
+				}
+			}
+		}
+	}
+
+	TMap<FGameplayTag, FAbilityTagRelationshipEntry> Entries;
+};
+
 /**
  * Mapping of how ability tags block or cancel other abilities.
  */
@@ -43,6 +92,16 @@ class CRIMABILITYSYSTEM_API UAbilityTagRelationshipMapping : public UDataAsset
 	GENERATED_BODY()
 
 public:
+	//~UObject interface
+	virtual void PostLoad() override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+	//~End of UObject interface
+
+	/** Returns the relationships compiled into a hash table, compiling them first if needed. */
+	const FAbilityTagRelationshipTable& GetCompiledTable() const;
+
 	/** Given a set of ability tags, parse the tag relationship and fill out tags to block and cancel */
 	void GetAbilityTagsToBlockAndCancel(const FGameplayTagContainer& AbilityTags, FGameplayTagContainer* OutTagsToBlock, FGameplayTagContainer* OutTagsToCancel) const;
 
@@ -52,8 +111,22 @@ public:
 	/** Returns true if the specified ability tags are canceled by the passed in action tag */
 	bool IsAbilityCancelledByTag(const FGameplayTagContainer& AbilityTags, const FGameplayTag& ActionTag) const;
 
+	/**
+	 * Returns the table of an ordered stack of mappings, merging them on first use. Every caller using the same stack
+	 * shares the same table, which is released once nothing references it. Returns null if there are no valid layers.
+	 * Must be called from the game thread.
+	 */
+	static TSharedPtr<const FAbilityTagRelationshipTable> FindOrCompileLayers(TConstArrayView<const UAbilityTagRelationshipMapping*> Layers);
+
+	/** Returns a counter that is bumped whenever any mapping is edited, so tags expanded through the old tables can be discarded. */
+	static uint32 GetMappingGeneration();
+
 private:
 	/** The list of relationships between different gameplay tags (which ones block or cancel others) */
 	UPROPERTY(EditDefaultsOnly, Category = Ability, meta = (TitleProperty = "Ability Tag"))
 	TArray<FAbilityTagRelationship> AbilityTagRelationships;
+
+	// AbilityTagRelationships compiled at load. Rebuilt when the relationships are edited.
+	mutable FAbilityTagRelationshipTable CompiledTable;
+	mutable bool bCompiled = false;
 };
@@ -114,6 +114,7 @@ public:
 
 protected:
 
+	virtual void OnRegister() override;
 	virtual void OnUnregister() override;
 
 	void ClearGameplayTags();
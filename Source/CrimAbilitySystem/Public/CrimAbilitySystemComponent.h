@@ -5,12 +5,138 @@
 #include "CoreMinimal.h"
 #include "AbilitySystemComponent.h"
 #include "Ability/CrimGameplayAbility.h"
+#include "AbilitySpecQuery.h"
+#include "CrimGameplayTagBitSet.h"
+#include "Ability/AbilityCooldownTypes.h"
+#include "Ability/AbilityChargeTypes.h"
+#include "Ability/Cost/AbilityCost.h"
 #include "CrimAbilitySystemComponent.generated.h"
 
 
 class UAbilityTagRelationshipMapping;
+class UAbilityInteractionMatrix;
+struct FAbilityTagRelationshipTable;
 
 DECLARE_MULTICAST_DELEGATE_TwoParams(FCrimAbilitySystemAbilitySpecSignature, UCrimAbilitySystemComponent* /*this ASC*/, const FGameplayAbilitySpec& /* The Ability Spec */);
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FCrimAbilitySystemAbilityAvailabilitySignature, UCrimAbilitySystemComponent* /*this ASC*/, FGameplayAbilitySpecHandle /* The Ability Spec Handle */, bool /* bCanActivate */);
+DECLARE_MULTICAST_DELEGATE_FourParams(FCrimAbilitySystemNativeCooldownSignature, UCrimAbilitySystemComponent* /*this ASC*/, const FGameplayTag& /* The Cooldown Tag */, float /* TimeRemaining */, float /* Duration */);
+DECLARE_MULTICAST_DELEGATE_TwoParams(FCrimAbilitySystemAbilitySpecHandlesSignature, UCrimAbilitySystemComponent* /*this ASC*/, TArrayView<const FGameplayAbilitySpecHandle> /* The Ability Spec Handles */);
+
+/**
+ * A running ability and the spec it was activated from. For instanced abilities this is the instance, otherwise the CDO.
+ */
+struct FCrimActiveAbility
+{
+	TWeakObjectPtr<UGameplayAbility> Ability;
+	FGameplayAbilitySpecHandle Handle;
+
+	bool operator==(const FCrimActiveAbility& Other) const
+	{
+		return Ability == Other.Ability && Handle == Other.Handle;
+	}
+};
+
+/**
+ * An ability activation failure sent to the owning client. The failure tags are sent as their net indices.
+ */
+USTRUCT()
+struct FCrimAbilityFailureNotify
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TObjectPtr<const UGameplayAbility> Ability;
+
+	UPROPERTY()
+	TArray<uint16> FailureTagNetIndices;
+};
+
+/**
+ * The activation required and blocked tags of an ability class expanded through the TagRelationshipMapping.
+ */
+struct FCrimAbilityActivationTagRequirements
+{
+	FGameplayTagContainer RequiredTags;
+	FGameplayTagContainer BlockedTags;
+
+	// RequiredTags and BlockedTags compiled to bit sets. Only valid when bHasBits is set.
+	FCrimGameplayTagBitSet RequiredBits;
+	FCrimGameplayTagBitSet BlockedBits;
+	bool bHasBits = false;
+};
+
+/**
+ * The block and cancel tags of an ability class expanded through the TagRelationshipMapping.
+ */
+struct FCrimAbilityBlockAndCancelTags
+{
+	FGameplayTagContainer BlockTags;
+	FGameplayTagContainer CancelTags;
+
+	// False when the mapping adds nothing, the containers are empty and the ability's own tags are used instead.
+	bool bMappingAddsTags = false;
+};
+
+/**
+ * The per ability class tags expanded through one merged tag relationship table. Kept for the recently used mapping
+ * stacks, so switching back to a stack reuses what was already expanded.
+ */
+struct FCrimTagRelationshipCache
+{
+	// The merged table of the mapping stack, null if the stack is empty.
+	TSharedPtr<const FAbilityTagRelationshipTable> Table;
+
+	TMap<TObjectKey<UClass>, FCrimAbilityActivationTagRequirements> ActivationTagRequirements;
+	TMap<TObjectKey<UClass>, FCrimAbilityBlockAndCancelTags> BlockAndCancelTags;
+};
+
+/**
+ * The abilities of one ASC to check with UCrimAbilitySystemComponent::CanActivateAbilitiesBatch.
+ */
+struct FCrimAbilityActivationBatch
+{
+	UCrimAbilitySystemComponent* AbilitySystemComponent = nullptr;
+
+	// The ability specs to check.
+	TArray<FGameplayAbilitySpecHandle> Handles;
+
+	// Bit N is set when Handles[N] can activate. Filled by CanActivateAbilitiesBatch.
+	TBitArray<> CanActivate;
+};
+
+/**
+ * The cached CanActivateAbility result of a spec and what it depends on.
+ */
+struct FCrimAbilityAvailability
+{
+	// Owned tags that can change the result: the activation requirements and the cooldown tags.
+	FGameplayTagContainer RelevantTags;
+
+	// The ability's asset tags, which other abilities' block tags are matched against.
+	FGameplayTagContainer AbilityTags;
+
+	// Attributes read by the ability's costs.
+	TArray<FGameplayAttribute, TInlineAllocator<2>> CostAttributes;
+
+	// The ASC's TagRelationshipGeneration when RelevantTags were gathered. They are gathered again on the next check after it changed.
+	uint32 TagRelationshipGeneration = 0;
+
+	// True if the ability is in an exclusive activation group.
+	bool bExclusive = false;
+
+	bool bCanActivate = false;
+	bool bDirty = true;
+};
+
+/**
+ * A failure that was recently sent to the client, used to drop repeats of it.
+ */
+struct FCrimRecentAbilityFailure
+{
+	TWeakObjectPtr<const UGameplayAbility> Ability;
+	FGameplayTagContainer FailureReason;
+	double Time = 0.0;
+};
 
 UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
 class CRIMABILITYSYSTEM_API UCrimAbilitySystemComponent : public UAbilitySystemComponent
@@ -20,37 +146,187 @@ class CRIMABILITYSYSTEM_API UCrimAbilitySystemComponent : public UAbilitySystemC
 public:
 	UCrimAbilitySystemComponent();
 
+	// Called for each ability given or removed, and for replicated abilities on clients. Batches broadcast them after the batch.
 	FCrimAbilitySystemAbilitySpecSignature OnAbilityGivenDelegate;
 	FCrimAbilitySystemAbilitySpecSignature OnAbilityRemovedDelegate;
 
+	// Called when a tracked ability's availability changes. See GetAbilityAvailability.
+	FCrimAbilitySystemAbilityAvailabilitySignature OnAbilityAvailabilityChangedDelegate;
+
+	// Called once per GiveAbilities/ClearAbilities call with every ability that was given or removed.
+	FCrimAbilitySystemAbilitySpecHandlesSignature OnAbilitiesGivenDelegate;
+	FCrimAbilitySystemAbilitySpecHandlesSignature OnAbilitiesRemovedDelegate;
+
+	// Called when a native cooldown starts or is extended, including predicted ones. See ApplyNativeCooldown.
+	FCrimAbilitySystemNativeCooldownSignature OnNativeCooldownAppliedDelegate;
+
+	//~UObject interface
+	virtual void PostInitProperties() override;
+	//~End of UObject interface
+
 	//~UActorComponent interface
 	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void GetLifetimeReplicatedProps(TArray<class FLifetimeProperty>& OutLifetimeProps) const override;
 	//~End of UActorComponent interface
 
 	virtual void InitAbilityActorInfo(AActor* InOwnerActor, AActor* InAvatarActor) override;
 
+	/** Cancels the running CrimGameplayAbilities that pass ShouldCancelFunc. Only running abilities are visited. */
 	typedef TFunctionRef<bool(const UCrimGameplayAbility* CrimAbility, FGameplayAbilitySpecHandle Handle)> TShouldCancelAbilityFunc;
 	void CancelAbilitiesByFunc(TShouldCancelAbilityFunc ShouldCancelFunc, bool bReplicateCancelAbility);
+
+	/** Cancels running abilities by their AssetTags. Only the running abilities with a matching tag are visited. */
+	virtual void CancelAbilities(const FGameplayTagContainer* WithTags = nullptr, const FGameplayTagContainer* WithoutTags = nullptr, UGameplayAbility* Ignore = nullptr) override;
 	
 	bool IsActivationGroupBlocked(EAbilityActivationGroup Group) const;
-	void AddAbilityToActivationGroup(EAbilityActivationGroup Group, UCrimGameplayAbility* CrimAbility);
-	void RemoveAbilityFromActivationGroup(EAbilityActivationGroup Group, UCrimGameplayAbility* CrimAbility);
+	void AddAbilityToActivationGroup(EAbilityActivationGroup Group, UCrimGameplayAbility* CrimAbility, FGameplayAbilitySpecHandle Handle);
+	void RemoveAbilityFromActivationGroup(EAbilityActivationGroup Group, UCrimGameplayAbility* CrimAbility, FGameplayAbilitySpecHandle Handle);
 	void CancelActivationGroupAbilities(EAbilityActivationGroup Group, UCrimGameplayAbility* IgnoreCrimAbility, bool bReplicateCancelAbility);
 
+	/** Returns true if any running ability of the spec is currently in the activation group. */
+	bool IsAbilitySpecRunningInActivationGroup(FGameplayAbilitySpecHandle Handle, EAbilityActivationGroup Group) const;
+
+	/**
+	 * Grants all the abilities as a single batch that is marked for replication once. OnSpawn activation and
+	 * OnAbilityGivenDelegate for each ability are deferred until every ability has been given, then
+	 * OnAbilitiesGivenDelegate is broadcast once. While the ability list is locked the abilities are given one at a time
+	 * once it unlocks instead. Authority only, nothing is given or written to OutHandles without it.
+	 * @param AbilitySpecs The abilities to grant.
+	 * @param OutHandles Optional. Receives a handle for each spec in the same order, invalid if the grant failed.
+	 */
+	void GiveAbilities(TArrayView<const FGameplayAbilitySpec> AbilitySpecs, TArray<FGameplayAbilitySpecHandle>* OutHandles = nullptr);
+
+	/**
+	 * Removes all the abilities as a single batch that is marked for replication once. OnAbilityRemovedDelegate is
+	 * broadcast for each ability after the batch, then OnAbilitiesRemovedDelegate once. While the ability list is locked
+	 * the abilities are removed one at a time once it unlocks instead, and OnAbilitiesRemovedDelegate is broadcast on the
+	 * next tick. Authority only.
+	 * @param Handles The abilities to remove. Invalid handles are skipped.
+	 */
+	void ClearAbilities(TArrayView<const FGameplayAbilitySpecHandle> Handles);
+
+	/** Returns the number of ability failure notifications that were not sent to the client because they repeated within AbilityFailureNotifyWindow. */
+	int32 GetSuppressedAbilityFailureCount() const { return SuppressedAbilityFailureCount; }
+
+	/** Returns true while GiveAbilities or ClearAbilities is processing its batch. */
+	bool IsProcessingAbilityBatch() const { return bIsProcessingAbilityBatch; }
+
 	/** Gets the ability target data associated with the given ability handle and activation info */
 	void GetAbilityTargetData(const FGameplayAbilitySpecHandle AbilityHandle, FGameplayAbilityActivationInfo ActivationInfo, FGameplayAbilityTargetDataHandle& OutTargetDataHandle);
 
 	/** Sets the current tag relationship mapping, if null it will clear it out */
 	void SetTagRelationshipMapping(UAbilityTagRelationshipMapping* NewMapping);
+
+	/**
+	 * Pushes a mapping layer on top of the TagRelationshipMapping, e.g. for a game mode, stance or vehicle seat. The
+	 * relationships of every layer are merged. Stacks are merged once and shared between ASCs, so pushing and popping a
+	 * layer only swaps to the stack's cached table.
+	 */
+	void PushTagRelationshipMapping(UAbilityTagRelationshipMapping* Mapping);
+
+	/** Removes the topmost instance of a mapping layer added with PushTagRelationshipMapping. */
+	void RemoveTagRelationshipMapping(UAbilityTagRelationshipMapping* Mapping);
+
+	/**
+	 * Starts the cooldown of each tag, ending Duration seconds from now. The end times are replicated instead of a cooldown
+	 * gameplay effect and the tags are granted as loose tags until they end. Clients predict the cooldown until the
+	 * server's replicates, and drop it if the activation's prediction key is rejected.
+	 */
+	void ApplyNativeCooldown(const FGameplayTagContainer& CooldownTags, float Duration, const FGameplayAbilityActivationInfo& ActivationInfo);
+
+	/** Returns true if any of the tags is on a native cooldown. */
+	bool IsNativeCooldownActive(const FGameplayTagContainer& CooldownTags) const;
+
+	/** Gets the longest time remaining and its duration of the native cooldowns of the tags. Returns false if none is running. */
+	bool GetNativeCooldownTimeRemainingAndDuration(const FGameplayTagContainer& CooldownTags, float& OutTimeRemaining, float& OutDuration) const;
+
+	/** Returns the charges the ability spec has now, MaxCharges if it never spent one. Includes this client's predicted use. */
+	int32 GetAbilityCharges(FGameplayAbilitySpecHandle Handle, int32 MaxCharges) const;
+
+	/** Returns the seconds until the ability spec refills its next charge, zero when it has all of them. */
+	float GetAbilityChargeTimeRemaining(FGameplayAbilitySpecHandle Handle, int32 MaxCharges) const;
+
+	/**
+	 * Spends charges of the ability spec. The server replicates the charge count, last refill time and recharge period to
+	 * the owner. Clients predict the use until the server's charges replicate, and restore them if the activation's
+	 * prediction key is rejected.
+	 */
+	void ConsumeAbilityCharges(FGameplayAbilitySpecHandle Handle, int32 Count, int32 MaxCharges, float RechargePeriod, const FGameplayAbilityActivationInfo& ActivationInfo);
+
+	/** Returns the server world time when it is known, the local world time otherwise. Native cooldowns and ability charges are measured in it. */
+	double GetServerWorldTimeSeconds() const;
+
+	/**
+	 * Returns the cost results of the ability spec for its current activation, creating them if needed. They are kept for
+	 * the frame until any ability of this component applies its cost or an attribute read by the spec's costs changes.
+	 * Returns null off the game thread.
+	 */
+	FAbilityCostEvaluationContext* GetCostEvaluationContext(FGameplayAbilitySpecHandle Handle) const;
+
+	/** Discards the cached cost results of every spec, called after an ability applied its cost. */
+	void InvalidateCostEvaluations();
+
+	/** Sets the prebuilt interaction matrix used to cancel abilities without matching their tags, null clears it. */
+	void SetAbilityInteractionMatrix(UAbilityInteractionMatrix* NewMatrix);
 	
 	/** Looks at ability tags and gathers additional required and blocking tags */
 	void GetAdditionalActivationTagRequirements(const FGameplayTagContainer& AbilityTags, FGameplayTagContainer& OutActivationRequired, FGameplayTagContainer& OutActivationBlocked) const;
 
+	/**
+	 * Returns whether the ability can currently activate and starts tracking it. Tracked abilities are only re-checked when
+	 * their activation required/blocked tags, cooldown tags, cost attributes, blocked ability tags, active state or the
+	 * activation groups change, and OnAbilityAvailabilityChangedDelegate is broadcast when the result flips.
+	 * @param Handle The ability spec to check.
+	 */
+	bool GetAbilityAvailability(FGameplayAbilitySpecHandle Handle);
+
+	/** Stops tracking the availability of the ability. */
+	void StopTrackingAbilityAvailability(FGameplayAbilitySpecHandle Handle);
+
+	/**
+	 * Checks which abilities can activate on many ASCs at once. The specs and cached tag requirements are resolved on the
+	 * game thread, then the read-only checks (blocked ability tags, already active, cooldown tags, activation tag
+	 * requirements and activation group) run in parallel across the batches. Costs and Blueprint CanActivateAbility
+	 * overrides are not evaluated, activation still runs the full check. Must be called from the game thread.
+	 * @param Batches The ASCs and ability specs to check. CanActivate is filled for each batch.
+	 */
+	static void CanActivateAbilitiesBatch(TArrayView<FCrimAbilityActivationBatch> Batches);
+
+	/**
+	 * Returns the ability's activation required and blocked tags with the additional tags from the TagRelationshipMapping.
+	 * The result is cached per ability class until the mapping changes. The reference is only valid until the next call.
+	 */
+	const FCrimAbilityActivationTagRequirements& GetActivationTagRequirements(const UCrimGameplayAbility& Ability) const;
+
+	/**
+	 * Returns the owned tags by reference, without copying them. The snapshot matches GetOwnedTagGeneration, so consumers
+	 * can store the generation with whatever they derive from the tags and skip the work until it changes.
+	 */
+	const FGameplayTagContainer& GetOwnedTagSnapshot() const { return GetOwnedGameplayTags(); }
+
+	/** Returns a counter that is bumped whenever an owned tag is added or removed. */
+	uint32 GetOwnedTagGeneration() const { return OwnedTagGeneration; }
+
+	/** Returns the owned gameplay tags and their parents as a bit set to compare against compiled activation requirements. */
+	const FCrimGameplayTagBitSet& GetOwnedGameplayTagBits() const;
+
+	/** Returns the cached activation tag requirements of the ability class or nullptr if they have not been cached. Never modifies the cache. */
+	const FCrimAbilityActivationTagRequirements* FindActivationTagRequirements(const UCrimGameplayAbility& Ability) const;
+
 	virtual void AbilitySpecInputPressed(FGameplayAbilitySpec& Spec) override;
 	virtual void AbilitySpecInputReleased(FGameplayAbilitySpec& Spec) override;
 
+	/**
+	 * Finds the ability spec with the matching handle. Unlike FindAbilitySpecFromHandle this is a hash lookup
+	 * into an index of the activatable abilities that is kept valid across grants, removals and replication.
+	 * @param Handle The handle of the ability spec.
+	 * @return The ability spec or nullptr if none.
+	 */
+	FGameplayAbilitySpec* GetAbilitySpecByHandle(FGameplayAbilitySpecHandle Handle);
+
 	/**
 	 * Finds the first ability with the passed in AbilityTag in the ability's AbilityTags.
+	 * Uses the AbilityTag index, so the cost does not depend on the number of granted abilities.
 	 * @param AbilityTag The ability to find.
 	 * @return The ability spec or nullptr if none.
 	 */
@@ -65,6 +341,7 @@ public:
 
 	/**
 	 * Find's the first ability with the Tag in the ability's DynamicSpecTags.
+	 * Uses the DynamicTag index, so this is a single hash lookup.
 	 * @param DynamicTag The tag to search for.
 	 */
 	FGameplayAbilitySpec* GetAbilitySpecWithDynamicTag(const FGameplayTag& DynamicTag);
@@ -78,6 +355,7 @@ public:
 
 	/**
 	 * Find's the first ability with the matching ability class.
+	 * Uses the ability class index, so the cost does not depend on the number of granted abilities.
 	 * @param AbilityClass The ability to search for.
 	 */
 	FGameplayAbilitySpec* GetAbilitySpecByClass(TSubclassOf<UGameplayAbility> AbilityClass);
@@ -88,9 +366,41 @@ public:
 	 * @param OutAbilitySpecs 
 	 */
 	void GetAllAbilitySpecsByClass(TSubclassOf<UGameplayAbility> AbilityClass, TArray<FGameplayAbilitySpec*>& OutAbilitySpecs);
+
+	/**
+	 * Calls Func for each ability spec that matches the query, stopping when Func returns false. The candidates come from
+	 * the smallest index the query can use (class, AssetTag, DynamicTag or running activation group) and nothing is allocated.
+	 * Func must not change the dynamic tags of specs. Grants and removals made by Func are deferred until the query ends.
+	 * @param Query The conditions the specs must match.
+	 * @param Func Called with each matching spec. Return false to stop.
+	 */
+	void ForEachAbilitySpec(const FCrimAbilitySpecQuery& Query, TFunctionRef<bool(FGameplayAbilitySpec& AbilitySpec)> Func);
+
+	/** Returns the first ability spec that matches the query or nullptr if none. */
+	FGameplayAbilitySpec* FindAbilitySpec(const FCrimAbilitySpecQuery& Query);
+
+	/**
+	 * Gets all the ability specs that match the query. Use an inline allocator to avoid allocating.
+	 * @param Query The conditions the specs must match.
+	 * @param OutAbilitySpecs Reset and filled with the matching specs.
+	 */
+	template<typename AllocatorType>
+	void GetAbilitySpecs(const FCrimAbilitySpecQuery& Query, TArray<FGameplayAbilitySpec*, AllocatorType>& OutAbilitySpecs)
+	{
+		OutAbilitySpecs.Reset();
+		ForEachAbilitySpec(Query, [&OutAbilitySpecs](FGameplayAbilitySpec& AbilitySpec)
+		{
+			OutAbilitySpecs.Add(&AbilitySpec);
+			return true;
+		});
+	}
+
+	/** Returns the index of granted ability classes to their spec handles. Kept up to date as abilities are given and removed. */
+	const TMultiMap<const UClass*, FGameplayAbilitySpecHandle>& GetAbilityClassToSpecHandles() const { return AbilityClassToSpecHandles; }
 	
 	/**
 	 * Adds the specified GameplayTag to the dynamic tags of the AbilitySpec in it's AbilityTags.
+	 * The DynamicTag is exclusive, it is removed from whichever spec previously owned it.
 	 * @param AbilitySpec The ability to add the DynamicTag to.
 	 * @param DynamicTag The Tag to add.
 	 */
@@ -115,19 +425,253 @@ protected:
 
 	virtual void OnGiveAbility(FGameplayAbilitySpec& AbilitySpec) override;
 	virtual void OnRemoveAbility(FGameplayAbilitySpec& AbilitySpec) override;
+	virtual void OnRep_ActivateAbilities() override;
+	virtual void OnTagUpdated(const FGameplayTag& Tag, bool TagExists) override;
 
-	/** Notify client that an ability failed to activate */
+	/** Notify client that abilities failed to activate */
 	UFUNCTION(Client, Unreliable)
-	void ClientNotifyAbilityFailed(const UGameplayAbility* Ability, const FGameplayTagContainer& FailureReason);
+	void ClientNotifyAbilitiesFailed(const TArray<FCrimAbilityFailureNotify>& AbilityFailures);
+
+	/** Queues the failure to be sent to the client with the other failures this frame, unless it was sent within AbilityFailureNotifyWindow. */
+	void QueueAbilityFailedNotify(const UGameplayAbility* Ability, const FGameplayTagContainer& FailureReason);
+
+	/** Sends the queued ability failures to the client. */
+	void FlushAbilityFailedNotifies();
+
+	/** Schedules BroadcastDeferredClearedAbilities for the next tick, if it is not already. */
+	void ScheduleDeferredClearedAbilitiesBroadcast();
+
+	/** Broadcasts OnAbilitiesRemovedDelegate for the abilities ClearAbilities removed while the ability list was locked. */
+	void BroadcastDeferredClearedAbilities();
 
 	void HandleAbilityFailed(const UGameplayAbility* Ability, const FGameplayTagContainer& FailureReason);
 
+	// Called by NativeCooldowns when a cooldown is added, extended or removed, on the server and when replicated.
+	void OnNativeCooldownChanged(const FAbilityCooldownItem& Item);
+	void OnNativeCooldownRemoved(const FAbilityCooldownItem& Item);
+	friend struct FAbilityCooldownItem;
+	friend struct FAbilityCooldownContainer;
+
+	// Called by AbilityCharges when the charges of a spec are spent on the server and when replicated.
+	void OnAbilityChargesChanged(const FAbilityChargeItem& Item);
+	friend struct FAbilityChargeItem;
+	friend struct FAbilityChargeContainer;
+
 private:
+
+	// Adds the spec to the AbilityTag and ability class indexes. Called when the ability is granted.
+	void AddAbilitySpecToIndexes(const FGameplayAbilitySpec& AbilitySpec);
+	// Removes the spec from the AbilityTag and ability class indexes. Called when the ability is removed.
+	void RemoveAbilitySpecFromIndexes(const FGameplayAbilitySpec& AbilitySpec);
+
+	// Returns the ability's block and cancel tags expanded through the TagRelationshipMapping, cached per ability class.
+	const FCrimAbilityBlockAndCancelTags& GetBlockAndCancelTags(const UCrimGameplayAbility& Ability);
+
+	// Returns true if the AbilityInteractionMatrix matches the mapping stack, is up to date and covers every granted ability.
+	bool CanUseAbilityInteractionMatrix() const;
+
+	// Returns the expanded tag cache of the current mapping stack, switching to the stack's table after it changed.
+	FCrimTagRelationshipCache& GetTagRelationshipCache() const;
+
+	// Called after the TagRelationshipMapping or its layers changed.
+	void HandleTagRelationshipMappingChanged();
+
+	// Grants or removes the loose cooldown tag depending on whether its native cooldown is running. IgnoreItem is being removed.
+	void RefreshNativeCooldownTag(const FGameplayTag& CooldownTag, const FAbilityCooldownItem* IgnoreItem = nullptr);
+
+	// Returns the charges of the spec, the predicted ones if this client spent a charge the server hasn't confirmed yet.
+	const FAbilityChargeItem* FindAbilityCharges(FGameplayAbilitySpecHandle Handle) const;
+
+	// Nothing ticks while charges refill. Sets the spec's timer to re-check its tracked availability once its charge costs
+	// can be paid again, or clears it when they can already or the spec isn't tracked.
+	void ScheduleAbilityChargeRecheck(FGameplayAbilitySpecHandle Handle);
+
+	// Sets the timer for the next native cooldown to end.
+	void ScheduleNativeCooldownTimer();
+	void HandleNativeCooldownTimer();
+
+	// Cancels a running ability from the active ability registry.
+	void CancelActiveAbility(const FCrimActiveAbility& ActiveAbility, bool bReplicateCancelAbility);
+
+	// Rebuilds the spec handle to ActivatableAbilities index map.
+	void RebuildSpecHandleIndex();
+
+	// Gathers what the spec's availability depends on.
+	void InitAbilityAvailability(const FGameplayAbilitySpec& AbilitySpec, FCrimAbilityAvailability& Availability);
+	// Gathers the relevant tags of the spec through the current mapping stack and adds them to AvailabilityHandlesByTag.
+	void GatherAbilityAvailabilityTags(const FGameplayAbilitySpec& AbilitySpec, FCrimAbilityAvailability& Availability);
+	// Gathers the relevant tags again if the mapping stack changed since they were gathered.
+	void UpdateAbilityAvailabilityTags(FGameplayAbilitySpecHandle Handle, FCrimAbilityAvailability& Availability);
+	// Removes the spec's relevant tags from AvailabilityHandlesByTag.
+	void RemoveAbilityAvailabilityTags(FGameplayAbilitySpecHandle Handle, const FCrimAbilityAvailability& Availability);
+	// Runs CanActivateAbility for the spec.
+	bool EvaluateAbilityAvailability(FGameplayAbilitySpecHandle Handle);
+	// Marks the availability dirty and schedules a refresh for the next tick.
+	void MarkAbilityAvailabilityDirty(FCrimAbilityAvailability& Availability);
+	void MarkAbilityAvailabilityDirty(FGameplayAbilitySpecHandle Handle);
+	// Re-checks the dirty availabilities and broadcasts the ones that changed.
+	void RefreshAbilityAvailability();
+	void HandleAvailabilityAttributeChanged(const FOnAttributeChangeData& Data);
+	// Marks the tracked abilities matching a blocked ability tag dirty when the tag is first added or last removed.
+	void HandleBlockedAbilityTagChanged(const FGameplayTag Tag, int32 NewCount);
+
+	// Adds the attributes modified and captured by the ability's cost gameplay effect and read by its additional costs.
+	static void GatherCostAttributes(const UGameplayAbility& AbilityCDO, TArray<FGameplayAttribute>& OutAttributes);
+	// Binds the cost attributes of a granted spec so their changes invalidate the spec's cached cost results.
+	void BindCostEvaluationAttributes(const FGameplayAbilitySpec& AbilitySpec);
+	// Removes a spec that is being removed from CostEvaluationHandlesByAttribute.
+	void RemoveCostEvaluationAttributes(const FGameplayAbilitySpec& AbilitySpec);
+	void HandleCostAttributeChanged(const FOnAttributeChangeData& Data);
+
+	// Adds the spec's current dynamic tags to the DynamicTag index.
+	void AddAbilitySpecToDynamicTagIndex(const FGameplayAbilitySpec& AbilitySpec);
+	// Removes the spec's current dynamic tags from the DynamicTag index.
+	void RemoveAbilitySpecFromDynamicTagIndex(const FGameplayAbilitySpec& AbilitySpec);
+	// Rebuilds the DynamicTag index from the activatable abilities. Clients receive dynamic tag changes through replication.
+	void RebuildDynamicTagIndex();
 	
+	// Identical ability failures are only sent to the client once within this many seconds.
+	UPROPERTY(EditAnywhere, Category = "CrimAbilitySystem", meta = (ClampMin = "0.0", Units = "s"))
+	float AbilityFailureNotifyWindow = 0.5f;
+
+	// Failures waiting to be sent to the client at the end of the frame.
+	TArray<FCrimAbilityFailureNotify> PendingAbilityFailures;
+
+	// Failures sent to the client within AbilityFailureNotifyWindow.
+	TArray<FCrimRecentAbilityFailure> RecentAbilityFailures;
+
+	// Number of failures that were dropped because they repeated within AbilityFailureNotifyWindow.
+	int32 SuppressedAbilityFailureCount = 0;
+
+	// True while FlushAbilityFailedNotifies is scheduled for the next tick.
+	bool bAbilityFailureFlushPending = false;
+
+	// True while GiveAbilities or ClearAbilities is processing its batch.
+	bool bIsProcessingAbilityBatch = false;
+
+	// Abilities given or removed during the current batch, their per ability delegates are broadcast after it.
+	TArray<FGameplayAbilitySpecHandle> BatchGivenAbilitySpecHandles;
+	TArray<FGameplayAbilitySpec> BatchRemovedAbilitySpecs;
+
+	// Abilities ClearAbilities queued for removal while the ability list was locked.
+	TArray<FGameplayAbilitySpecHandle> DeferredClearedAbilityHandles;
+
+	// True while BroadcastDeferredClearedAbilities is scheduled for the next tick.
+	bool bDeferredClearedAbilitiesBroadcastPending = false;
+
 	// Mapping of how ability tags block or cancel other abilities.
 	UPROPERTY(EditAnywhere, Category = "CrimAbilitySystem")
 	TObjectPtr<UAbilityTagRelationshipMapping> TagRelationshipMapping;
 
+	// Block and cancel relations resolved offline for the TagRelationshipMapping. Only used while no layers are pushed.
+	UPROPERTY(EditAnywhere, Category = "CrimAbilitySystem")
+	TObjectPtr<UAbilityInteractionMatrix> AbilityInteractionMatrix;
+
+	// Number of granted ability specs whose class is not in the AbilityInteractionMatrix.
+	int32 NumAbilitiesOutsideInteractionMatrix = 0;
+
+	// Mapping layers pushed on top of the TagRelationshipMapping, in push order.
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UAbilityTagRelationshipMapping>> TagRelationshipLayers;
+
+	// Expanded tags of the recently used mapping stacks, the current one is at ActiveTagRelationshipCache.
+	mutable TArray<FCrimTagRelationshipCache, TInlineAllocator<4>> TagRelationshipCaches;
+	mutable int32 ActiveTagRelationshipCache = INDEX_NONE;
+
+	// UAbilityTagRelationshipMapping::GetMappingGeneration when TagRelationshipCaches were built.
+	mutable uint32 TagRelationshipCachesMappingGeneration = 0;
+
+	// Bumped whenever the mapping stack or one of its mappings changes.
+	mutable uint32 TagRelationshipGeneration = 0;
+
 	// Number of abilities running in each activation group.
 	int32 ActivationGroupCounts[(uint8)EAbilityActivationGroup::MAX];
+
+	// The owned tags compiled against the tag bit set universe. Rebuilt on use after the owned tags or the universe change.
+	mutable FCrimGameplayTagBitSet OwnedTagBits;
+	mutable uint32 OwnedTagBitsUniverseGeneration = 0;
+	mutable uint32 OwnedTagBitsGeneration = 0;
+
+	// Bumped whenever an owned tag is added or removed.
+	uint32 OwnedTagGeneration = 1;
+
+	// Cached availability of the tracked ability specs.
+	TMap<FGameplayAbilitySpecHandle, FCrimAbilityAvailability> AbilityAvailability;
+
+	// The tracked specs that depend on each relevant tag, so a tag change only marks those dirty.
+	TMap<FGameplayTag, TArray<FGameplayAbilitySpecHandle, TInlineAllocator<2>>> AvailabilityHandlesByTag;
+
+	// The tracked specs keyed by each of their AbilityTags and the parent tags, so a block tag change only marks those dirty.
+	TMap<FGameplayTag, TArray<FGameplayAbilitySpecHandle, TInlineAllocator<2>>> AvailabilityHandlesByAbilityTag;
+
+	// The tracked specs keyed by each of their cost attributes, so an attribute change only marks those dirty.
+	TMap<FGameplayAttribute, TArray<FGameplayAbilitySpecHandle, TInlineAllocator<2>>> AvailabilityHandlesByAttribute;
+
+	// Cost attributes whose change delegate is bound for the availability cache.
+	TArray<FGameplayAttribute> AvailabilityBoundAttributes;
+
+	// True while RefreshAbilityAvailability is scheduled for the next tick.
+	bool bAbilityAvailabilityRefreshPending = false;
+
+	// Running CrimGameplayAbilities in each activation group.
+	TArray<FCrimActiveAbility> ActiveAbilitiesByGroup[(uint8)EAbilityActivationGroup::MAX];
+
+	// Running abilities keyed by each of their AssetTags and the parent tags. Emptied buckets are removed.
+	TMap<FGameplayTag, TArray<FCrimActiveAbility>> ActiveAbilitiesByTag;
+
+	// Running abilities that are not CrimGameplayAbilities, only kept to report them when CancelAbilitiesByFunc skips them.
+	TArray<FCrimActiveAbility> ActiveNonCrimAbilities;
+
+	// Maps each spec handle to its index in ActivatableAbilities.Items.
+	TMap<FGameplayAbilitySpecHandle, int32> SpecHandleToIndex;
+
+	// Set when ActivatableAbilities.Items may have been reordered by replication, SpecHandleToIndex is rebuilt on the next lookup.
+	// Grants and removals on the server update the index in place.
+	bool bSpecHandleIndexDirty = true;
+
+	// Maps each ability AssetTag (and its parent tags) to the handles of the granted abilities that have it, in grant order.
+	TMap<FGameplayTag, TArray<FGameplayAbilitySpecHandle>> AbilityTagToSpecHandles;
+
+	// Maps each granted ability class to the handles of its specs.
+	TMultiMap<const UClass*, FGameplayAbilitySpecHandle> AbilityClassToSpecHandles;
+
+	// Handles of the specs whose ability uses EAbilityActivationPolicy::OnSpawn.
+	TArray<FGameplayAbilitySpecHandle> OnSpawnAbilitySpecHandles;
+
+	// Maps each dynamic spec tag (and its parent tags) to the handles of the specs that have it. Exact tags have a single owner when set through AddDynamicTagToAbilitySpec.
+	TMap<FGameplayTag, TArray<FGameplayAbilitySpecHandle>> DynamicTagToSpecHandles;
+
+	// Cooldowns applied through ApplyNativeCooldown.
+	UPROPERTY(Replicated)
+	FAbilityCooldownContainer NativeCooldowns;
+
+	// Cooldowns predicted by this client, until the server's replicate or they end.
+	TMap<FGameplayTag, FAbilityCooldownItem> PredictedNativeCooldowns;
+
+	// Cooldown tags currently granted as loose tags for native cooldowns.
+	TSet<FGameplayTag> GrantedNativeCooldownTags;
+
+	FTimerHandle NativeCooldownTimerHandle;
+
+	// Charges of the specs that spent any, replicated to the owner.
+	UPROPERTY(Replicated)
+	FAbilityChargeContainer AbilityCharges;
+
+	// Charges predicted by this client, until the server's replicate.
+	TMap<FGameplayAbilitySpecHandle, FAbilityChargeItem> PredictedAbilityCharges;
+
+	// Timers that re-check tracked specs once they have enough charges again.
+	TMap<FGameplayAbilitySpecHandle, FTimerHandle> AbilityChargeTimerHandles;
+
+	// Cost results per spec, valid for the frame and generation they are stamped with.
+	mutable TMap<FGameplayAbilitySpecHandle, FAbilityCostEvaluationContext> CostEvaluationContexts;
+
+	// Incremented whenever a cost was applied or charges changed, which outdates every context.
+	uint32 CostEvaluationGeneration = 0;
+
+	// Cost attributes of the granted specs whose change delegate invalidates the cost results.
+	TArray<FGameplayAttribute> CostEvaluationBoundAttributes;
+
+	// The granted specs whose costs read each attribute, so a change only resets their contexts.
+	TMap<FGameplayAttribute, TArray<FGameplayAbilitySpecHandle>> CostEvaluationHandlesByAttribute;
 };
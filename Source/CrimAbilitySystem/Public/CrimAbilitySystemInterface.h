@@ -25,6 +25,7 @@ class CRIMABILITYSYSTEM_API ICrimAbilitySystemInterface
 public:
 	/**
 	 * When InitActorInfo is called, all components on the AvatarActor and OwnerActor can respond when the ASC is configured.
+	 * Components added after the actor was first initialized should register with UCrimGlobalAbilitySystem to be found.
 	 * @param NewAbilitySystemComponent The ability system component to initialize with.
 	 */
 	UFUNCTION(BlueprintNativeEvent)
@@ -0,0 +1,84 @@
+﻿// Copyright Soccertitan 2025
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "Math/VectorRegister.h"
+
+/**
+ * A fixed width set of gameplay tags. Each tag in the plugin's tag universe (the tags used by the compiled activation
+ * requirements) gets one bit, so HasAny and HasAll are a couple of SIMD ands and compares instead of container loops.
+ *
+ * Sets of owned tags include the bits of each tag's parents, so HasAny/HasAll keep the FGameplayTagContainer semantics
+ * when the other set is compiled from exact tags.
+ */
+struct CRIMABILITYSYSTEM_API FCrimGameplayTagBitSet
+{
+	static constexpr int32 NumBits = 256;
+	static constexpr int32 NumWords = NumBits / 64;
+
+	void Reset()
+	{
+		FMemory::Memzero(Words, sizeof(Words));
+	}
+
+	void SetBit(int32 Bit)
+	{
+		check(Bit >= 0 && Bit < NumBits);
+		Words[Bit >> 6] |= (uint64(1) << (Bit & 63));
+	}
+
+	bool IsEmpty() const
+	{
+		return (Words[0] | Words[1] | Words[2] | Words[3]) == 0;
+	}
+
+	/** Returns true if any bit in Other is set in this set. */
+	FORCEINLINE bool HasAny(const FCrimGameplayTagBitSet& Other) const
+	{
+		const VectorRegister4Int Low = VectorIntAnd(VectorIntLoadAligned(&Words[0]), VectorIntLoadAligned(&Other.Words[0]));
+		const VectorRegister4Int High = VectorIntAnd(VectorIntLoadAligned(&Words[2]), VectorIntLoadAligned(&Other.Words[2]));
+		const VectorRegister4Int IsZero = VectorIntCompareEQ(VectorIntOr(Low, High), GlobalVectorConstants::IntZero);
+		return VectorMaskBits(VectorCastIntToFloat(IsZero)) != 0xF;
+	}
+
+	/** Returns true if every bit in Other is set in this set. An empty Other always passes. */
+	FORCEINLINE bool HasAll(const FCrimGameplayTagBitSet& Other) const
+	{
+		const VectorRegister4Int OtherLow = VectorIntLoadAligned(&Other.Words[0]);
+		const VectorRegister4Int OtherHigh = VectorIntLoadAligned(&Other.Words[2]);
+		const VectorRegister4Int LowMatches = VectorIntCompareEQ(VectorIntAnd(VectorIntLoadAligned(&Words[0]), OtherLow), OtherLow);
+		const VectorRegister4Int HighMatches = VectorIntCompareEQ(VectorIntAnd(VectorIntLoadAligned(&Words[2]), OtherHigh), OtherHigh);
+		return VectorMaskBits(VectorCastIntToFloat(VectorIntAnd(LowMatches, HighMatches))) == 0xF;
+	}
+
+	alignas(16) uint64 Words[NumWords] = {};
+};
+
+/**
+ * Assigns the bits of FCrimGameplayTagBitSet. Tags are only ever added, so compiled sets stay valid, but owned tag
+ * sets must be rebuilt when the generation changes. Registration is game thread only.
+ */
+class CRIMABILITYSYSTEM_API FCrimGameplayTagBitSetUniverse
+{
+public:
+	static FCrimGameplayTagBitSetUniverse& Get();
+
+	/**
+	 * Compiles the exact tags of the container, registering any new tags.
+	 * @return False if the universe is full, OutBits can't be used.
+	 */
+	bool CompileExact(const FGameplayTagContainer& Tags, FCrimGameplayTagBitSet& OutBits);
+
+	/** Compiles the tags and all their parents. Tags outside the universe are skipped since nothing tests for them. */
+	void CompileWithParents(const FGameplayTagContainer& Tags, FCrimGameplayTagBitSet& OutBits) const;
+
+	/** Bumped whenever a tag is added to the universe. */
+	uint32 GetGeneration() const { return Generation; }
+
+private:
+	TMap<FGameplayTag, int32> TagToBit;
+	uint32 Generation = 0;
+	bool bWarnedFull = false;
+};
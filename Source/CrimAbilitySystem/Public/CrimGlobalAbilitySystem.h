@@ -12,6 +12,7 @@ class UGameplayAbility;
 class UGameplayEffect;
 class UCrimAbilitySystemComponent;
 class UObject;
+class UActorComponent;
 
 USTRUCT()
 struct FGlobalAppliedAbilityList
@@ -39,6 +40,18 @@ struct FGlobalAppliedEffectList
 	void RemoveFromAll();
 };
 
+/** Components on an actor that implement ICrimAbilitySystemInterface. */
+struct FCrimAbilitySystemInterfaceComponents
+{
+	TArray<TWeakObjectPtr<UActorComponent>> Components;
+
+	// The actor the components belong to, used to drop the entry if the actor is destroyed without ending play.
+	TWeakObjectPtr<AActor> Actor;
+
+	// True once the actor was scanned for the interface. Later changes come from component registration.
+	bool bScanned = false;
+};
+
 /**
  * 
  */
@@ -69,7 +82,42 @@ public:
 	/** Removes an ASC from the global system, along with any active global effects/abilities. */
 	void UnregisterAbilitySystemComponent(UCrimAbilitySystemComponent* AbilitySystemComponent);
 
+	/**
+	 * Registers a component that implements ICrimAbilitySystemInterface with its owning actor. Components that are
+	 * added after the actor was first initialized with an ability system must register to be initialized, e.g. from
+	 * OnRegister, and unregister from OnUnregister.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Crim Ability System|Global")
+	void RegisterAbilitySystemInterfaceComponent(UActorComponent* Component);
+
+	/** Removes a component that was registered with RegisterAbilitySystemInterfaceComponent. */
+	UFUNCTION(BlueprintCallable, Category = "Crim Ability System|Global")
+	void UnregisterAbilitySystemInterfaceComponent(UActorComponent* Component);
+
+	/**
+	 * Calls Func for each component on the actor that implements ICrimAbilitySystemInterface. The actor's components are
+	 * scanned the first time it is seen, after that only the cached list kept up to date by component registration is
+	 * walked. Components that were destroyed or moved to another actor are dropped from the list.
+	 */
+	void ForEachAbilitySystemInterfaceComponent(AActor* Actor, TFunctionRef<void(UActorComponent* Component)> Func);
+
 private:
+
+	// Gets the interface component list for the actor, forgetting it when the actor ends play.
+	FCrimAbilitySystemInterfaceComponents& FindOrAddInterfaceComponents(AActor* Actor);
+
+	// Drops the lists of actors that were destroyed without ending play.
+	void PruneInterfaceComponents();
+
+	UFUNCTION()
+	void HandleActorEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason);
+
+	// Components that implement ICrimAbilitySystemInterface keyed by their owning actor.
+	TMap<TObjectKey<AActor>, FCrimAbilitySystemInterfaceComponents> InterfaceComponentsByActor;
+
+	// InterfaceComponentsByActor is pruned when it grows to this many entries.
+	int32 InterfaceComponentsPruneThreshold = 64;
+
 	UPROPERTY()
 	TMap<TSubclassOf<UGameplayAbility>, FGlobalAppliedAbilityList> AppliedAbilities;
 